@@ -0,0 +1,103 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class ChannelKind { Pipe, Socket, SharedMemory, Semaphore };
+
+const char* to_string(ChannelKind kind);
+
+// Plain copy of a ChannelCounters, safe to keep and compare.
+struct ChannelStats {
+    std::uint64_t bytesIn = 0;
+    std::uint64_t bytesOut = 0;
+    std::uint64_t messagesIn = 0;
+    std::uint64_t messagesOut = 0;
+    std::uint64_t syscalls = 0;
+    std::uint64_t shortWrites = 0;
+    std::uint64_t wouldBlock = 0;   // EAGAIN / EWOULDBLOCK
+    std::uint64_t waits = 0;        // semaphore waits that had to block
+    std::uint64_t waitNanos = 0;    // time spent blocked in those waits
+
+    ChannelStats& operator+=(const ChannelStats& o);
+};
+
+// Per-instance counters owned by each channel. Updates are relaxed atomic
+// increments on the instance itself, so the hot path never touches shared
+// state; instances register themselves so ipc::metrics() can find them, and
+// fold their totals into a per-kind sum when destroyed.
+class ChannelCounters {
+public:
+    explicit ChannelCounters(ChannelKind kind);
+    ~ChannelCounters();
+    ChannelCounters(const ChannelCounters&) = delete;
+    ChannelCounters& operator=(const ChannelCounters&) = delete;
+
+    void read(std::uint64_t bytes)    { bump(bytesIn, bytes); bump(messagesIn, 1); }
+    void wrote(std::uint64_t bytes)   { bump(bytesOut, bytes); bump(messagesOut, 1); }
+    void syscall(std::uint64_t n = 1) { bump(syscalls, n); }
+    void shortWrite()                 { bump(shortWrites, 1); }
+    void blocked()                    { bump(wouldBlock, 1); }
+    void waited(std::chrono::steady_clock::duration d) {
+        bump(waits, 1);
+        bump(waitNanos, static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()));
+    }
+
+    ChannelKind kind() const { return channelKind; }
+    ChannelStats snapshot() const;
+    void reset();
+
+    // Free-form owner description ("cat[1234] stdout"), shown in metrics.
+    void setLabel(std::string text);
+    std::string label() const;
+
+private:
+    static void bump(std::atomic<std::uint64_t>& c, std::uint64_t n) {
+        c.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    ChannelKind channelKind;
+    std::atomic<std::uint64_t> bytesIn{0}, bytesOut{0}, messagesIn{0}, messagesOut{0};
+    std::atomic<std::uint64_t> syscalls{0}, shortWrites{0}, wouldBlock{0};
+    std::atomic<std::uint64_t> waits{0}, waitNanos{0};
+};
+
+#ifndef _WIN32
+// Gathered write of records to fd, shared by the pipe and socket channels.
+// writev() takes at most IOV_MAX buffers and may accept only part of them,
+// so this loops, resuming mid-record after a short write, until everything
+// is written or the fd would block or fails. Updates counters and returns
+// the bytes written.
+std::size_t write_records(int fd, std::span<const std::string_view> records,
+                          ChannelCounters& counters);
+#endif
+
+namespace ipc {
+
+struct ChannelMetrics {
+    ChannelKind kind;
+    std::string label;
+    ChannelStats stats;
+};
+
+struct MetricsSnapshot {
+    std::vector<ChannelMetrics> channels;  // live instances
+    ChannelStats totals[4];                // per ChannelKind, including closed ones
+
+    const ChannelStats& total(ChannelKind kind) const {
+        return totals[static_cast<int>(kind)];
+    }
+
+    std::string toText() const;
+    std::string toJson() const;
+};
+
+// Library-wide snapshot of every channel in this process.
+MetricsSnapshot metrics();
+
+}
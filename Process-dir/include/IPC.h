@@ -4,12 +4,23 @@
 #include "Pipe.h"
 #include "SocketChannel.h"
 #include "SharedMemoryChannel.h"
-#include "Semaphore.h"
+#include "SharedSemaphore.h"
+#include "ChannelCounters.h"
+#include "Pipeline.h"
+#include "JobGraph.h"
+#include "WorkerPool.h"
+#include "TypedChannel.h"
+#include "RpcChannel.h"
 
 namespace ipc {
     using Process       = ::Process;
     using PipeChannel   = ::Pipe;
     using SocketChannel = ::SocketChannel;
     using SharedMemory  = ::SharedMemoryChannel;
+    using Semaphore     = ::SharedSemaphore;
+    using Rpc           = ::RpcChannel;
 
-}
\ No newline at end of file
+    template <class T>
+    using Typed         = ::TypedChannel<T>;
+
+}
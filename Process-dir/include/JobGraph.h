@@ -0,0 +1,88 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+
+#include "Process.h"
+
+// Runs a dependency graph of external commands. Ready nodes are started in
+// parallel up to a concurrency limit, and data flows along edges while the
+// producers are still running.
+//
+//   pipe(a, b)   b's stdin is fed a's stdout. b may start as soon as a has
+//                started; a node with several inputs reads them in the
+//                order the edges were added, after its own setInput() data.
+//   after(a, b)  b starts only once a has exited with status 0.
+//
+// A node whose producer failed or was skipped is itself skipped. Every
+// node's stdout and stderr are captured in its result, except that the
+// stdout of a node with consumers is released once all of them have been
+// fed it (see keepStdout()). A producer is not read while a consumer that
+// is currently reading it lags more than the edge buffer behind.
+class JobGraph {
+public:
+    using NodeId = size_t;
+    using Clock = std::chrono::steady_clock;
+
+    enum class NodeState { Pending, Succeeded, Failed, Skipped };
+
+    struct NodeResult {
+        NodeState state = NodeState::Pending;
+        ExitStatus status;
+        ProcessStats stats;
+        std::string stdoutData;        // may hold only the unreleased tail
+        std::uint64_t stdoutBytes = 0; // everything the node wrote to stdout
+        std::string stderrData;
+        Clock::time_point started{};
+        Clock::time_point finished{};
+        Clock::duration wallTime() const { return finished - started; }
+    };
+
+    JobGraph();
+    ~JobGraph();
+    JobGraph(const JobGraph&) = delete;
+    JobGraph& operator=(const JobGraph&) = delete;
+
+    NodeId add(const std::string& name, const std::string& path,
+               const std::vector<std::string>& args, const SpawnOptions& options = {});
+    void setInput(NodeId node, std::string data);
+    void pipe(NodeId from, NodeId to);
+    void after(NodeId before, NodeId node);
+    // Keep a producer's whole stdout in its result instead of releasing
+    // what its consumers have already been fed.
+    void keepStdout(NodeId node, bool keep = true);
+
+    // 0: one per hardware thread.
+    void setConcurrency(size_t limit) { concurrency = limit; }
+    // Backlog a consumer may fall behind its producer before the producer
+    // stops being read. A consumer that has not started or is still reading
+    // an earlier input does not hold its producers back, so their output is
+    // buffered for it without limit.
+    void setEdgeBuffer(size_t bytes) { edgeBuffer = bytes ? bytes : 1; }
+
+    // Runs the whole graph; true if every node succeeded. Throws on cycles.
+    bool run();
+
+    size_t size() const { return nodes.size(); }
+    const std::string& name(NodeId node) const;
+    const NodeResult& result(NodeId node) const;
+
+    // Heaviest dependency chain by wall time, first node first.
+    std::vector<NodeId> criticalPath() const;
+    Clock::duration criticalPathTime() const;
+
+    // One line per node: state, start offset, wall time, CPU time.
+    std::string report() const;
+
+private:
+    struct Node;
+
+    std::vector<std::unique_ptr<Node>> nodes;
+    size_t concurrency = 0;
+    size_t edgeBuffer = size_t(1) << 20;
+    Clock::time_point runStarted{};
+
+    std::vector<NodeId> topologicalOrder() const;
+};
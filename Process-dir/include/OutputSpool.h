@@ -0,0 +1,62 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+// Collects a child's output without holding it all on the heap. Data is
+// buffered in memory up to 'memoryLimit', then spills into an anonymous
+// temporary file (O_TMPFILE, or an unlinked mkstemp file), and is read back
+// through a read-only mapping of that file. Once spilled, pipe input is
+// spliced straight into the file where the kernel allows it.
+class OutputSpool {
+public:
+    static constexpr size_t defaultMemoryLimit = 1 << 20;
+
+    // spillDirectory: empty means $TMPDIR, else /tmp (Windows: GetTempPath).
+    explicit OutputSpool(size_t memoryLimit = defaultMemoryLimit,
+                         std::string spillDirectory = {});
+    ~OutputSpool();
+    OutputSpool(const OutputSpool&) = delete;
+    OutputSpool& operator=(const OutputSpool&) = delete;
+
+    void append(const char* data, size_t len);
+    void append(std::string_view data) { append(data.data(), data.size()); }
+
+#ifndef _WIN32
+    // Reads fd to EOF into the spool; returns the number of bytes added.
+    std::uint64_t readFrom(int fd);
+#endif
+
+    std::uint64_t size() const { return total; }
+    bool spilled() const { return spillFile != invalidFile; }
+
+    // Read-only view of everything appended so far; valid until the next
+    // append. Spilled data is mapped, not copied.
+    std::string_view view();
+
+    void clear();
+
+private:
+#ifdef _WIN32
+    using file_handle = void*;
+    static constexpr file_handle invalidFile = nullptr;
+    void* mapping = nullptr;
+#else
+    using file_handle = int;
+    static constexpr file_handle invalidFile = -1;
+#endif
+
+    size_t memoryLimit;
+    std::string directory;
+    std::string memory;
+    std::uint64_t total = 0;
+
+    file_handle spillFile = invalidFile;
+    void* mapped = nullptr;
+    std::uint64_t mappedSize = 0;
+
+    void spill();
+    void writeFile(const char* data, size_t len);
+    void unmap();
+};
@@ -1,5 +1,9 @@
 #pragma once
 #include <string>
+#include <string_view>
+#include <span>
+#include "ChannelCounters.h"
+#include "OutputSpool.h"
 #ifdef _WIN32
 #include <windows.h>
 #else
@@ -15,17 +19,43 @@ public:
     void closeRead();
     void closeWrite();
     std::string readAll();
+    // Like readAll(), but into a spool that spills to a mapped file.
+    std::uint64_t readAllTo(OutputSpool& spool);
     void write(const std::string& data);
+    // Writes all records back to back with as few syscalls as possible.
+    void writeMany(std::span<const std::string_view> records);
+
+    // Single read/write for callers multiplexing several pipes: readSome
+    // appends what one read returns (0: EOF, -1: nothing available or
+    // error), writeSome returns the bytes accepted or -1.
+    long readSome(std::string& out, size_t maxBytes = 65536);
+    long writeSome(std::string_view data);
+
+    // Fixed-size binary I/O: writeBytes returns false unless every byte was
+    // written; readExact returns false on EOF or error before 'len' bytes,
+    // with the bytes it did read in 'received' (0: the stream ended cleanly).
+    bool writeBytes(const void* data, size_t len);
+    bool readExact(void* out, size_t len, size_t* received = nullptr);
+#ifndef _WIN32
+    void setNonBlocking(bool on);
+#endif
+
+    ChannelCounters& counters() { return channelCounters; }
 
 #ifdef _WIN32
+    // Takes ownership of existing handles (e.g. a child's own stdin/stdout).
+    void adopt(HANDLE read, HANDLE write);
     HANDLE getReadHandle() const { return hRead; }
     HANDLE getWriteHandle() const { return hWrite; }
 #else
+    void adopt(int read, int write);
     int getReadFD() const { return readFD; }
     int getWriteFD() const { return writeFD; }
 #endif
 
 private:
+    ChannelCounters channelCounters{ChannelKind::Pipe};
+
 #ifdef _WIN32
     HANDLE hRead{nullptr};
     HANDLE hWrite{nullptr};
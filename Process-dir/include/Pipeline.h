@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "Process.h"
+
+// A | B | C: each stage's stdout is connected straight to the next stage's
+// stdin with a kernel pipe, so all stages run concurrently and no data
+// passes through the parent. The parent feeds the first stage's stdin,
+// reads the last stage's stdout, and keeps every stage's stderr and exit
+// status.
+class Pipeline {
+public:
+    Pipeline() = default;
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    Pipeline& add(const std::string& path, const std::vector<std::string>& args,
+                  const SpawnOptions& options = {});
+
+    bool start();
+
+    void writeStdin(const std::string& input);   // first stage
+    void closeStdin();
+    std::string readStdout();                    // last stage, until EOF
+    std::string readStderr(size_t stage);
+
+    // Waits for every stage; exit codes in stage order (-1: killed by a signal).
+    std::vector<int> wait();
+    // True once every stage has exited with status 0 (like "set -o pipefail").
+    bool succeeded() const;
+
+    size_t size() const { return stages.size(); }
+    Process& stage(size_t i) { return *stages.at(i); }
+    const ExitStatus& exitStatus(size_t i) const { return stages.at(i)->exitStatus(); }
+
+    void terminate();
+
+private:
+    std::vector<std::unique_ptr<Process>> stages;
+    std::vector<std::unique_ptr<Pipe>> links;   // links[i]: stage i -> stage i+1
+};
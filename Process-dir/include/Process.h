@@ -1,39 +1,157 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
+#include <span>
+#include <chrono>
+#include <memory>
 
 #include "Pipe.h"
 #include "SocketChannel.h"
 #include "SharedMemoryChannel.h"
 #include "SharedSemaphore.h"
+#include "SharedMemoryRegistry.h"
+#include "SpawnArena.h"
+#include "TransportHints.h"
+
+#ifndef _WIN32
+#include <signal.h>
+#endif
+
+// How a child ended. 'code' is only meaningful when 'exited' is set;
+// 'signal' holds the terminating signal otherwise (POSIX only).
+struct ExitStatus {
+    bool exited = false;
+    int code = -1;
+    int signal = 0;
+    bool coreDumped = false;
+};
+
+// Resource usage of a reaped child (wait4 on POSIX). Wall-clock times are
+// taken by the parent at spawn and at reap.
+struct ProcessStats {
+    double userCpuSeconds = 0;
+    double systemCpuSeconds = 0;
+    long maxRssKb = 0;
+    long voluntaryContextSwitches = 0;
+    long involuntaryContextSwitches = 0;
+    long minorPageFaults = 0;
+    long majorPageFaults = 0;
+    std::chrono::system_clock::time_point startTime;
+    std::chrono::system_clock::time_point endTime;
+    std::chrono::steady_clock::duration wallTime{};
+};
 
 class Process {
 public:
-    Process(const std::string& path, const std::vector<std::string>& args);
+    Process(const std::string& path, const std::vector<std::string>& args,
+            const SpawnOptions& options = {});
+    ~Process();
 
     bool start();  // pipes
+    // Like start(), but the child's stdin reads from stdinFrom and/or its
+    // stdout writes into stdoutTo instead of a pipe to the parent (nullptr
+    // keeps the parent pipe). The caller keeps both pipes and closes its
+    // copies of the ends it handed over.
+    bool startPiped(Pipe* stdinFrom, Pipe* stdoutTo);
     bool startSockets(unsigned short basePort, SocketType type = SocketType::Unix);
-    bool startSharedMemory(size_t size = 4096);
+    bool startSharedMemory(size_t size = 4096, SharedMemoryMode mode = SharedMemoryMode::Named);
+    // Picks the fastest transport in hints.supported for the declared
+    // traffic and starts with it; throws if none of them fits.
+    bool startAuto(const TransportHints& hints);
+    Transport transport() const;
+
+    int wait();     // exit code, -1 if the child was killed by a signal
+    bool tryWait(); // reaps without blocking; true once the child is gone
+    const ExitStatus& exitStatus() const { return status; }
+    const ProcessStats& stats() const { return usage; }
 
-    int wait();
+    // Blocks until one of the running children exits, reaps it and returns
+    // it; nullptr when none of them is running.
+    static Process* waitAny(std::span<Process> procs);
+    static Process* waitAny(std::span<Process* const> procs);
+
+    // Starts 'count' copies of the (unstarted) prototype in pipe mode. All
+    // pipes are created before the first child, the compiled SpawnArena is
+    // shared rather than rebuilt per child, and on POSIX each child comes
+    // from vfork(), whose cost does not grow with the parent's address
+    // space. Throws if a spawn fails; children already started are reaped.
+    static std::vector<std::unique_ptr<Process>> spawnMany(size_t count, const Process& prototype);
+
+#ifdef _WIN32
+    HANDLE getProcessHandle() const { return hProcess; }
+#else
+    pid_t getPid() const { return pid; }
+    // Becomes readable when the child exits; -1 if pidfds are unsupported.
+    int getPidFD() const { return pidFD; }
+#endif
+
+    // Pipe-mode streams, for callers multiplexing many children at once.
+    Pipe& stdinStream() { return stdinPipe; }
+    Pipe& stdoutStream() { return stdoutPipe; }
+    Pipe& stderrStream() { return stderrPipe; }
 
     std::string readStdout();
     std::string readStderr();
+    // Streams the rest of the output into a spool instead of one string.
+    std::uint64_t readStdoutTo(OutputSpool& spool);
+    std::uint64_t readStderrTo(OutputSpool& spool);
     void writeStdin(const std::string& input);
     void closeStdin();
+
+    // Batched stdin: the records are concatenated as-is (callers add their
+    // own delimiters) and delivered in one transfer with one wakeup. In
+    // shared-memory mode the batch must fit in the segment.
+    void writeStdinMany(std::span<const std::string_view> records);
+    void beginBatch();
+    void appendStdin(std::string_view record);
+    void flushStdin();
     void terminate();
 
 private:
     std::string executable;
     std::vector<std::string> arguments;
+    SpawnOptions options;
+    std::shared_ptr<const SpawnArena> arena;  // compiled in the constructor
 
 #ifdef _WIN32
     HANDLE hProcess = nullptr;
     HANDLE hThread = nullptr;
 #else
     pid_t pid = -1;
+    int pidFD = -1;
+
+    // Per-spawn plan, filled in by the parent before fork; the child only
+    // reads it. The vectors keep their capacity across spawns.
+    struct Redirect { int from; int to; };
+    static constexpr size_t maxRedirects = 8;   // execChild works on a fixed array
+    std::vector<std::string> transportArgs;
+    std::vector<char*> argvTable;
+    std::vector<Redirect> redirects;            // checked against maxRedirects before forking
+    std::vector<int> keepFds;   // inherited besides 0-2, sorted
+
+    // Copy of a prototype's command that reuses its compiled arena.
+    Process(const Process& prototype, std::shared_ptr<const SpawnArena> sharedArena);
+
+    void spawn();
+    void preparePipes(Pipe* stdinFrom, Pipe* stdoutTo);
+    void closeChildEnds();
+    // restoreMask: signal mask to reinstate just before execve (vfork path).
+    [[noreturn]] void execChild(const sigset_t* restoreMask = nullptr) const;
+    // vfork() + execChild(); returns the child's pid, or -1. Kept out of
+    // spawnMany's loop so none of its locals are live across vfork().
+    pid_t vforkChild(const sigset_t* restoreMask) const;
 #endif
 
+    ExitStatus status;
+    ProcessStats usage;
+    std::chrono::steady_clock::time_point spawnedAt;
+    bool reaped = false;
+
+    void onSpawned(int givenPidFD = -1);
+    void labelChannels(unsigned long childPid);
+    bool reap(bool block);
+
     // PIPE IPC
     Pipe stdinPipe, stdoutPipe, stderrPipe;
 
@@ -51,11 +169,21 @@ private:
 
     bool useSharedMemory = false;
     size_t shmSize = 0;
+    SharedMemoryMode shmMode = SharedMemoryMode::Named;
+    unsigned long shmId = 0;  // SharedMemoryRegistry id, 0 if none
     std::string shmBase;
 
     SharedMemoryChannel shmIn;
     SharedMemoryChannel shmOut;
+    SharedMemoryChannel shmErr;
 
     SharedSemaphore semIn;
     SharedSemaphore semOut;
+    SharedSemaphore semErr;
+
+    std::string stdinBatch;   // pending records between beginBatch() and flushStdin()
+
+    // Waits for the next message on a shared-memory stream; returns "" once
+    // the child shut the stream down or exited without posting.
+    std::string readShared(SharedMemoryChannel& shm, SharedSemaphore& sem);
 };
\ No newline at end of file
@@ -0,0 +1,147 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <unordered_map>
+
+#include "Pipe.h"
+#include "SocketChannel.h"
+#include "SharedWorkQueue.h"
+
+class Process;
+
+// Message framing shared by both ends of an RPC connection. On a byte
+// stream (pipe pair or socket) a frame is a 4-byte length, an 8-byte
+// correlation id and the payload; over a pair of SharedWorkQueues each
+// queue message is the id followed by the payload, so a payload is limited
+// to slotSize - 8. Id 0 is reserved for the close handshake.
+//
+// Shared memory has no EOF: a queue link ends when its input queue is shut
+// down, or when the optional 'peerAlive' check, polled while idle or while
+// the output queue is full, says the other side is gone.
+class RpcLink {
+public:
+    static constexpr std::uint32_t maxFrame = 64u << 20;
+    static constexpr int peerPollMs = 50;
+
+    RpcLink(Pipe& out, Pipe& in) : out(&out), in(&in) {}
+    explicit RpcLink(SocketChannel& socket) : socket(&socket) {}
+    RpcLink(SharedWorkQueue& out, SharedWorkQueue& in, std::function<bool()> peerAlive = {})
+        : queueOut(&out), queueIn(&in), alive(std::move(peerAlive)) {}
+
+    // Largest payload send() accepts; it throws beyond that.
+    size_t maxPayload() const { return queueOut ? queueOut->slotSize() - sizeof(std::uint64_t) : maxFrame; }
+
+    // Thread-safe with respect to other send() calls. timeoutMs (-1: no
+    // limit) bounds the wait for other senders and, on a queue link, for
+    // room in a full queue; false on timeout or once the link is down.
+    bool send(std::uint64_t id, std::string_view payload, int timeoutMs = -1);
+    // Single reader only. False on EOF or a malformed frame.
+    bool receive(std::uint64_t& id, std::string& payload);
+
+    // Makes a blocked receive() return false. Only queue links can be
+    // interrupted; on pipes and sockets the peer closing gives EOF instead.
+    bool interruptible() const { return queueIn != nullptr; }
+    void interrupt();
+
+private:
+    Pipe* out = nullptr;
+    Pipe* in = nullptr;
+    SocketChannel* socket = nullptr;
+    SharedWorkQueue* queueOut = nullptr;
+    SharedWorkQueue* queueIn = nullptr;
+    std::function<bool()> alive;
+    std::timed_mutex sending;
+
+    bool queuePeerGone() const;
+};
+
+// Client end: many requests outstanding on one channel, matched to their
+// responses by correlation id, so a slow reply does not hold back the
+// requests queued behind it and per-request IPC latency overlaps.
+//
+// A background thread reads responses and completes the future, or runs
+// the callback (on that thread). If the peer goes away, every outstanding
+// request fails: futures throw std::runtime_error, callbacks get ok=false.
+// Writing to a dead child raises SIGPIPE on POSIX; if the peer may exit
+// first, hold a SigpipeGuard in the threads that call and close (or ignore
+// SIGPIPE process-wide). Over shared-memory queues, pass 'peerAlive' so a dead
+// server is noticed; without it, outstanding requests fail at close().
+class RpcChannel {
+public:
+    static constexpr size_t defaultInFlight = 32;
+    // How long close() waits for a queue peer's acknowledgement before it
+    // gives up on it.
+    static constexpr std::chrono::milliseconds closeGrace{1000};
+    // Over queues, a request that finds no room for this long fails as if
+    // the peer were gone.
+    static constexpr std::chrono::milliseconds queueSendTimeout{5000};
+    using Callback = std::function<void(bool ok, std::string reply)>;
+
+    // Requests go to the child's stdin, responses come from its stdout.
+    explicit RpcChannel(Process& child, size_t maxInFlight = defaultInFlight);
+    RpcChannel(Pipe& requests, Pipe& responses, size_t maxInFlight = defaultInFlight);
+    explicit RpcChannel(SocketChannel& socket, size_t maxInFlight = defaultInFlight);
+    RpcChannel(SharedWorkQueue& requests, SharedWorkQueue& responses, size_t maxInFlight = defaultInFlight,
+               std::function<bool()> peerAlive = {});
+    ~RpcChannel();
+    RpcChannel(const RpcChannel&) = delete;
+    RpcChannel& operator=(const RpcChannel&) = delete;
+
+    // Both block while maxInFlight requests are outstanding, and throw if
+    // the channel is closed or the request exceeds the link's maxPayload().
+    std::future<std::string> call(std::string_view request);
+    void call(std::string_view request, Callback callback);
+
+    size_t inFlight() const;
+
+    // Tells the server to stop once it has answered everything before the
+    // close frame, then waits for those answers; requests still unanswered
+    // when the link ends fail. Over queues, a peer that does not answer
+    // within closeGrace is given up on. May be called from a callback, in
+    // which case it does not wait; the channel itself must not be destroyed
+    // from one of its callbacks.
+    void close();
+
+private:
+    struct Pending {
+        std::promise<std::string> promise;
+        Callback callback;
+    };
+
+    RpcLink link;
+    size_t limit;
+
+    mutable std::mutex lock;
+    std::condition_variable slotFree;   // also signalled when the reader stops
+    std::unordered_map<std::uint64_t, Pending> pending;
+    std::uint64_t nextId = 1;
+    bool closing = false;
+    bool finished = false;      // reader has stopped
+    std::thread reader;
+
+    std::uint64_t enqueue(Pending entry, size_t requestSize);
+    void submit(std::uint64_t id, std::string_view request);
+    void readLoop();
+    static void complete(Pending& p, bool ok, std::string reply);
+};
+
+// Server end: answers requests one at a time, in arrival order. Returns
+// when the client closes the channel or the link reaches EOF.
+class RpcServer {
+public:
+    RpcServer(Pipe& responses, Pipe& requests) : link(responses, requests) {}
+    explicit RpcServer(SocketChannel& socket) : link(socket) {}
+    RpcServer(SharedWorkQueue& responses, SharedWorkQueue& requests) : link(responses, requests) {}
+
+    void serve(const std::function<std::string(std::string_view)>& handler);
+
+private:
+    RpcLink link;
+};
@@ -0,0 +1,95 @@
+#pragma once
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#include "SharedMemoryChannel.h"
+
+// Self-relative pointer: stores the distance from itself to the target, so
+// structures built inside a shared segment stay valid in every process no
+// matter where the segment is mapped. Null is encoded as 0, which means an
+// OffsetPtr cannot point at itself.
+template <class T>
+class OffsetPtr {
+public:
+    OffsetPtr() = default;
+    OffsetPtr(T* p) { set(p); }
+    OffsetPtr(const OffsetPtr& other) { set(other.get()); }
+
+    OffsetPtr& operator=(const OffsetPtr& other) { set(other.get()); return *this; }
+    OffsetPtr& operator=(T* p) { set(p); return *this; }
+
+    T* get() const {
+        return off == 0 ? nullptr
+                        : reinterpret_cast<T*>(const_cast<char*>(reinterpret_cast<const char*>(this)) + off);
+    }
+    T* operator->() const { return get(); }
+    T& operator*() const { return *get(); }
+    explicit operator bool() const { return off != 0; }
+
+private:
+    void set(T* p) {
+        off = p ? reinterpret_cast<char*>(p) - reinterpret_cast<char*>(this) : 0;
+    }
+
+    std::ptrdiff_t off = 0;
+};
+
+// Allocator over a shared segment. Blocks are addressed by offsets from the
+// segment base; small requests come from power-of-two size-class free lists
+// and large ones from a first-fit list. A spin lock in the segment header
+// makes it safe across threads and processes.
+class SharedArena {
+public:
+    using offset_t = uint64_t;   // 0 is never a valid block
+
+    SharedArena();
+    ~SharedArena();
+
+    SharedArena(const SharedArena&) = delete;
+    SharedArena& operator=(const SharedArena&) = delete;
+
+    bool create(const std::string& name, size_t size);
+    bool open(const std::string& name, size_t size);
+    void close();
+
+    offset_t allocate(size_t bytes);
+    void deallocate(offset_t off);
+
+    void* get(offset_t off) const;
+    template <class T> T* get(offset_t off) const { return static_cast<T*>(get(off)); }
+    offset_t offsetOf(const void* p) const;
+
+    template <class T, class... Args>
+    T* construct(Args&&... args) {
+        offset_t off = allocate(sizeof(T));
+        return off ? new (get(off)) T(std::forward<Args>(args)...) : nullptr;
+    }
+
+    template <class T>
+    void destroy(T* p) {
+        if (!p) return;
+        p->~T();
+        deallocate(offsetOf(p));
+    }
+
+    // Well-known entry point for readers attaching to the segment.
+    void setRoot(offset_t off);
+    offset_t root() const;
+
+    size_t used() const;
+    size_t capacity() const { return shm.getSize(); }
+
+private:
+    struct Header;
+
+    bool attach(const std::string& name, size_t size, bool create);
+    void lock() const;
+    void unlock() const;
+
+    SharedMemoryChannel shm;
+    Header* header = nullptr;
+    char* base = nullptr;
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#include "SharedMemoryChannel.h"
+
+// Latest-value publication from one writer to any number of readers,
+// guarded by a seqlock. The writer never waits for readers and does no
+// per-reader work; a reader that races with a publish simply retries.
+class SharedBroadcast {
+public:
+    SharedBroadcast();
+    ~SharedBroadcast();
+
+    SharedBroadcast(const SharedBroadcast&) = delete;
+    SharedBroadcast& operator=(const SharedBroadcast&) = delete;
+
+    bool create(const std::string& name, size_t capacity);  // writer
+    bool open(const std::string& name, size_t capacity);    // readers
+    void close();
+
+    bool publish(const void* data, size_t len);
+    bool publish(const std::string& data) { return publish(data.data(), data.size()); }
+
+    // Copies the latest snapshot and returns its version (0 = nothing
+    // published yet).
+    uint64_t read(std::string& out) const;
+    // Copies only when a version newer than 'lastVersion' is available.
+    bool readIfNewer(uint64_t& lastVersion, std::string& out) const;
+
+    uint64_t version() const;
+    size_t capacity() const { return cap; }
+
+private:
+    struct Header;
+
+    bool attach(const std::string& name, size_t capacity, bool create);
+
+    SharedMemoryChannel shm;
+    Header* header = nullptr;
+    char* data = nullptr;
+    size_t cap = 0;
+};
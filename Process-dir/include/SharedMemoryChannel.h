@@ -1,5 +1,11 @@
 #pragma once
 #include <string>
+#include "ChannelCounters.h"
+
+enum class SharedMemoryMode {
+    Named,      // shm_open objects under /dev/shm, names passed on the command line
+    Anonymous   // memfd segments inherited by the child, passed as "fd:<n>"
+};
 
 class SharedMemoryChannel {
 public:
@@ -8,14 +14,25 @@ public:
 
     bool create(const std::string& name, size_t size);
     bool open(const std::string& name, size_t size);
+    bool createAnonymous(size_t size);
+
+    // NUMA placement of the segment's pages; call before the first write.
+    // Both are no-ops returning false where NUMA is unavailable.
+    bool bindToNumaNode(int node);
+    bool interleaveNumaNodes();
 
     bool write(const std::string& data);
     std::string read();
 
     void close();
 
+    ChannelCounters& counters() { return channelCounters; }
+
     void* getBuffer() const { return buffer; }
     size_t getSize() const { return size; }
+#ifndef _WIN32
+    int getFD() const { return fd; }
+#endif
 
 private:
 #ifdef _WIN32
@@ -28,4 +45,7 @@ private:
 
     size_t size = 0;
     std::string name;
+    bool named = false;
+    bool owner = false;     // created the named object, so unlinks it on close
+    ChannelCounters channelCounters{ChannelKind::SharedMemory};
 };
\ No newline at end of file
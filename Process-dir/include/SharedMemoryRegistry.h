@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <mutex>
+#include <unordered_set>
+
+// Hands out per-instance ids for shared-memory objects, so that one parent
+// can run many shared-memory children at the same time without their
+// segment and semaphore names colliding.
+class SharedMemoryRegistry {
+public:
+    static SharedMemoryRegistry& instance();
+
+    unsigned long acquire();
+    void release(unsigned long id);
+
+    // "/proc_<kind>_<pid>_<id>"
+    std::string name(const std::string& kind, unsigned long id) const;
+    size_t active() const;
+
+private:
+    SharedMemoryRegistry() = default;
+
+    mutable std::mutex mtx;
+    std::unordered_set<unsigned long> live;
+    unsigned long nextId = 1;
+};
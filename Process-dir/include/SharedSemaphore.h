@@ -2,6 +2,7 @@
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: https://pvs-studio.com
 #pragma once
 #include <string>
+#include "ChannelCounters.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -17,22 +18,42 @@ public:
     ~SharedSemaphore();
 
     void init(const std::string& name, bool create, int initialValue = 0);
-    void wait();
+    void initAnonymous(int initialValue = 0);
+    bool wait();                  // false once shut down and drained
+    bool waitFor(int timeoutMs);  // false on timeout or shutdown
     void post();
 
+    // Marks the semaphore closed (end of stream): pending and future waits
+    // return false once the count is used up.
+    void shutdown();
+    bool isShutdown() const;
+
+    // posts count as messagesOut, acquired waits as messagesIn
+    ChannelCounters& counters() { return channelCounters; }
+
+#ifndef _WIN32
+    int getFD() const { return shm.getFD(); }
+#endif
+
 private:
+    ChannelCounters channelCounters{ChannelKind::Semaphore};
+
 #ifdef _WIN32
     HANDLE hSem = NULL;
+    HANDLE hClosed = NULL;   // manual-reset event signalled by shutdown()
     bool creator = false;
 #else
     struct SemaphoreData {
         pthread_mutex_t mtx;
         pthread_cond_t  cond;
         int value;
+        int closed;
     };
 
     SharedMemoryChannel shm;
     SemaphoreData* data = nullptr;
     bool creator = false;
+
+    void setup(int initialValue);
 #endif
 };
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#include "SharedMemoryChannel.h"
+
+// Frame stream from one writer to one reader through three buffers in a
+// shared segment. The writer owns one buffer, the reader owns another, and
+// the third sits in the middle; ownership changes hands by exchanging the
+// middle index (plus a "fresh" bit) in the segment header. Neither side
+// ever waits: the writer always has a free buffer to fill, and the reader
+// always gets the newest complete frame, skipping any it was too slow for.
+//
+// create() attaches as the writer, open() as the reader. There is one
+// reader at a time; one that closes can be replaced by a later open(),
+// which takes over the buffer the previous reader held.
+class SharedTripleBuffer {
+public:
+    SharedTripleBuffer();
+    ~SharedTripleBuffer();
+
+    SharedTripleBuffer(const SharedTripleBuffer&) = delete;
+    SharedTripleBuffer& operator=(const SharedTripleBuffer&) = delete;
+
+    bool create(const std::string& name, size_t capacity);  // writer
+    bool open(const std::string& name, size_t capacity);    // reader
+    void close();
+
+    // Writer: fill writeBuffer() in place and commit() it, or publish() a copy.
+    void* writeBuffer();
+    bool commit(size_t len);
+    bool publish(const void* data, size_t len);
+    bool publish(const std::string& data) { return publish(data.data(), data.size()); }
+
+    // Reader: takes the newest frame if one arrived since the last acquire.
+    // The frame stays valid and untouched until the next successful acquire.
+    bool acquire();
+    const void* frontData() const;
+    size_t frontSize() const;
+    uint64_t frontFrame() const;    // 1-based frame number, 0 = none yet
+    // Copies the newest frame when there is one.
+    bool readLatest(std::string& out);
+
+    // Frames the reader never saw because a newer one replaced them.
+    uint64_t skipped() const { return framesSkipped; }
+    size_t capacity() const { return cap; }
+
+private:
+    struct Header;
+    struct Slot;
+
+    bool attach(const std::string& name, size_t capacity, bool create);
+    Slot* slot(unsigned index) const;
+
+    SharedMemoryChannel shm;
+    Header* header = nullptr;
+    char* slots = nullptr;
+    size_t cap = 0;
+    size_t stride = 0;
+
+    bool writer = false;
+    unsigned own = 0;               // buffer index this side holds
+    uint64_t framesWritten = 0;
+    uint64_t framesSkipped = 0;
+};
@@ -0,0 +1,71 @@
+#pragma once
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#include "SharedMemoryChannel.h"
+#include "SharedSemaphore.h"
+
+// Bounded multi-producer / multi-consumer queue living in one shared
+// segment (Vyukov's per-slot sequence numbers). Any number of processes can
+// open the same name and push or pop without a dispatcher in between;
+// consumers that find the queue empty sleep on a SharedSemaphore.
+class SharedWorkQueue {
+public:
+    SharedWorkQueue();
+    ~SharedWorkQueue();
+
+    SharedWorkQueue(const SharedWorkQueue&) = delete;
+    SharedWorkQueue& operator=(const SharedWorkQueue&) = delete;
+
+    // capacity is rounded up to a power of two; slotSize is the largest
+    // message in bytes. 'tag' is an opaque layout id stored in the header:
+    // open() fails unless it matches what create() stored.
+    bool create(const std::string& name, size_t capacity, size_t slotSize, uint64_t tag = 0);
+    bool open(const std::string& name, size_t capacity, size_t slotSize, uint64_t tag = 0);
+    void close();
+
+    // tryPush fails while the queue is full or once it is shut down. The
+    // pops throw if the next item is larger than outSize: it would block
+    // the queue for every later pop.
+    bool tryPush(const void* data, size_t len);
+    bool tryPush(const std::string& data) { return tryPush(data.data(), data.size()); }
+    bool tryPop(void* out, size_t outSize, size_t& len);
+    bool tryPop(std::string& out);
+
+    // push yields while the queue is full and throws once it is shut down.
+    void push(const std::string& data);
+    std::string pop();                   // sleeps while the queue is empty
+    void push(const void* data, size_t len);
+    size_t pop(void* out, size_t outSize);
+    // Sleeps at most timeoutMs (-1: no limit); false on timeout, or once
+    // the queue is shut down and drained.
+    bool pop(void* out, size_t outSize, size_t& len, int timeoutMs);
+
+    // Marks the queue closed for every process attached to it and wakes
+    // sleeping consumers. Items already queued can still be popped; after
+    // that the blocking pops return empty instead of sleeping, and pushes
+    // fail.
+    void shutdown();
+    bool isShutdown() const;
+
+    size_t capacity() const { return cap; }
+    size_t slotSize() const { return payload; }
+    uint64_t tag() const;
+
+private:
+    struct Header;
+    struct Slot;
+
+    bool attach(const std::string& name, size_t capacity, size_t slotSize, uint64_t tag, bool create);
+    Slot* slotAt(uint64_t pos) const;
+    void wakeConsumer();
+
+    SharedMemoryChannel shm;
+    SharedSemaphore notEmpty;
+    Header* header = nullptr;
+    char* slots = nullptr;
+    size_t cap = 0;
+    size_t payload = 0;
+    size_t stride = 0;
+};
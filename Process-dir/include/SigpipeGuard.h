@@ -0,0 +1,31 @@
+#pragma once
+
+#ifndef _WIN32
+#include <signal.h>
+#endif
+
+// Keeps a write to a pipe whose reader has exited from killing the process:
+// for the guard's lifetime SIGPIPE is blocked in the calling thread only, so
+// the write fails with EPIPE instead. The process-wide disposition is left
+// alone, so guards on different threads do not undo each other. A SIGPIPE
+// raised meanwhile is discarded before the old mask comes back.
+//
+// No-op on Windows, which has no SIGPIPE.
+class SigpipeGuard {
+public:
+    SigpipeGuard();
+    ~SigpipeGuard();
+    SigpipeGuard(const SigpipeGuard&) = delete;
+    SigpipeGuard& operator=(const SigpipeGuard&) = delete;
+
+    // True while a guard in the calling thread has SIGPIPE blocked. Process
+    // unblocks it again in children spawned meanwhile, since a blocked mask
+    // survives exec.
+    static bool active();
+
+#ifndef _WIN32
+private:
+    sigset_t old;
+    bool wasBlocked = false;   // the caller already blocked it; leave it be
+#endif
+};
@@ -1,7 +1,11 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <span>
 #include <cstdint>
+#include "ChannelCounters.h"
+#include "OutputSpool.h"
 
 #ifdef _WIN32
 using socket_handle = std::uintptr_t;
@@ -30,11 +34,21 @@ public:
     bool connectTo(const std::string& host, unsigned short port);
     void close();
     std::string readAll();
+    std::uint64_t readAllTo(OutputSpool& spool);
     void write(const std::string& data);
+    // Sends all records back to back in one gathered send where possible.
+    void writeMany(std::span<const std::string_view> records);
+    // Fixed-size binary I/O, all-or-nothing like Pipe::writeBytes/readExact.
+    bool writeBytes(const void* data, std::size_t len);
+    bool readExact(void* out, std::size_t len, std::size_t* received = nullptr);
+
+    // Counters belong to the object, not the socket: a move leaves them behind.
+    ChannelCounters& counters() { return channelCounters; }
 
 private:
     socket_handle sock;
     SocketType sockType{SocketType::Unix};
+    ChannelCounters channelCounters{ChannelKind::Socket};
 
 #ifdef _WIN32
     static bool wsaStarted;
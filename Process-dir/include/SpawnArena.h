@@ -0,0 +1,49 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include "SpawnOptions.h"
+
+// Everything a forked child needs to exec a command, compiled once into one
+// contiguous buffer: the resolved executable path, arguments, environment,
+// working directory and CPU/NUMA masks. The arena is immutable, so it can be
+// shared by every spawn of the same command; the child only reads it and
+// makes raw syscalls.
+class SpawnArena {
+public:
+    SpawnArena(const std::string& executable, const std::vector<std::string>& args,
+               const SpawnOptions& options);
+
+    SpawnArena(const SpawnArena&) = delete;
+    SpawnArena& operator=(const SpawnArena&) = delete;
+
+    // Fills 'table' with executable, 'prefix' (transport parameters) and the
+    // user arguments, NULL-terminated. 'table' keeps its capacity, so
+    // respawning with the same shape does not allocate.
+    void buildArgv(const std::vector<std::string>& prefix, std::vector<char*>& table) const;
+
+    const char* path() const { return storage.data() + pathOffset; }
+    char* const* envp() const { return envTable.empty() ? nullptr : envTable.data(); }
+    const char* workingDirectory() const { return hasCwd ? storage.data() + cwdOffset : nullptr; }
+
+#ifndef _WIN32
+    // Child side, async-signal-safe.
+    void applyPlacement() const;
+    void closeFdsExcept(const int* keep, size_t count) const;  // keep sorted
+#endif
+
+private:
+    size_t append(const std::string& s);
+
+    std::vector<char> storage;
+    size_t pathOffset = 0;
+    size_t cwdOffset = 0;
+    bool hasCwd = false;
+    std::vector<size_t> argOffsets;
+    std::vector<char*> envTable;
+
+    std::vector<unsigned long> cpuMask;
+    std::vector<unsigned long> nodeMask;
+    int fdLimit = 0;
+};
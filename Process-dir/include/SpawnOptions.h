@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <optional>
+
+class SpawnServer;
+
+// How a child is launched. A NUMA node also restricts the child to that
+// node's CPUs (unless 'cpus' is given) and places its shared-memory
+// segments on it.
+struct SpawnOptions {
+    std::vector<int> cpus;  // empty: inherit the parent's affinity
+    int numaNode = -1;      // -1: no NUMA placement
+
+    std::optional<std::vector<std::string>> environment;  // "KEY=value"; unset: inherit
+    std::string workingDirectory;                         // empty: inherit
+
+    // Fork through this (started) server instead of from the caller; see
+    // SpawnServer.h. POSIX only; must outlive the Process.
+    SpawnServer* spawnServer = nullptr;
+};
@@ -0,0 +1,94 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <cstddef>
+
+#include "SpawnOptions.h"
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/resource.h>
+#endif
+
+// A small helper process that forks and execs on behalf of its parent.
+//
+// fork() from a large process has to copy its page tables, so the cost of
+// launching even a tiny tool grows with the parent. start() forks the
+// server once, ideally early in main() while the parent is still small and
+// single-threaded; afterwards every spawn routed through it (set
+// SpawnOptions::spawnServer) is a request over a Unix seqpacket socket:
+// the arguments, and the descriptors the child must inherit passed with
+// SCM_RIGHTS together with the fd number each should end up on. The server
+// forks from its own small image, execs, and answers with the pid and a
+// pidfd for it.
+//
+// The server is the child's real parent, so only it can reap: wait()
+// blocks on the pidfd locally and then has the server run wait4.
+//
+// Preloaded workers: startTemplate() runs a program of your own as the
+// server instead. It initializes once (loads models, tables, ...) and then
+// calls serveTemplate(), which answers spawn requests by forking itself
+// and running workerMain in the child, with the request's argv and fresh
+// stdio/channels, instead of exec. Every worker starts warm and shares the
+// template's initialized memory copy-on-write:
+//
+//     int main(int argc, char** argv) {
+//         if (SpawnServer::isTemplate(argc, argv)) {
+//             loadEverything();
+//             SpawnServer::serveTemplate(argc, argv, workerMain);
+//         }
+//         ...
+//     }
+//
+// POSIX only; start() and startTemplate() return false on Windows.
+class SpawnServer {
+public:
+    using WorkerMain = std::function<int(int argc, char** argv)>;
+
+    SpawnServer();
+    ~SpawnServer();  // closes the socket; the server exits on EOF and is reaped
+    SpawnServer(const SpawnServer&) = delete;
+    SpawnServer& operator=(const SpawnServer&) = delete;
+
+    bool start();
+    // Launches 'path' as a template and waits until it reports ready, i.e.
+    // until its initialization is done; false if it exits first.
+    bool startTemplate(const std::string& path, const std::vector<std::string>& args,
+                       const SpawnOptions& options = {});
+    bool running() const { return sock != -1; }
+
+    // Template side. isTemplate() recognises the arguments startTemplate()
+    // adds; serveTemplate() never returns and exits once the parent closes
+    // the server. Workers get the spawning Process's argv and their exit
+    // code is workerMain's return value.
+    static bool isTemplate(int argc, char** argv);
+    [[noreturn]] static void serveTemplate(int argc, char** argv, const WorkerMain& workerMain);
+
+#ifndef _WIN32
+    pid_t serverPid() const { return server; }
+
+    // Execs 'path' with 'argv' (argv[0] included, NULL-terminated) and the
+    // placement, environment and working directory from 'options'. Each
+    // fds[i] is installed as targets[i] in the child; every other
+    // descriptor is closed. Returns the pid; 'pidFD' gets a pidfd for it,
+    // or -1 where the kernel has none. Throws if the request fails.
+    pid_t spawn(const std::string& path, char* const* argv, const SpawnOptions& options,
+                const int* fds, const int* targets, size_t count, int& pidFD);
+
+    // wait4() semantics for a child of the server: the pid once reaped, 0 if
+    // it is still running (block == false), -1 if the server does not know it.
+    pid_t wait(pid_t pid, int pidFD, bool block, int& rawStatus, struct rusage& usage);
+
+private:
+    // workerMain == nullptr: exec the request (plain spawn server).
+    [[noreturn]] static void serve(int fd, const WorkerMain* workerMain);
+    void call(const std::string& request, const int* fds, size_t count,
+              std::string& reply, int* receivedFd);
+
+    pid_t server = -1;
+#endif
+    int sock = -1;
+    std::mutex lock;   // one request/reply exchange at a time
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+// USDT (sys/sdt.h) static tracepoints under the "process" provider. Each
+// probe compiles to a single nop plus an ELF note, so they stay in release
+// builds; bpftrace/perf attach to them at run time, e.g.
+//
+//   bpftrace -e 'usdt:./libProcess.so:process:start__entry { @t[tid] = nsecs; }
+//                usdt:./libProcess.so:process:start__return /@t[tid]/ {
+//                    @spawn_us = hist((nsecs - @t[tid]) / 1000); delete(@t[tid]); }'
+//
+// Paired probes are named <op>__entry / <op>__return. Without PROCESS_USDT
+// (set by the ENABLE_USDT CMake switch when sys/sdt.h is found) the macros
+// expand to nothing and their arguments are not evaluated.
+//
+//   start__entry(transport)          start__return(pid, transport)
+//   wait__entry(pid)                 wait__return(pid, exit code or -signal)
+//   pipe_write__entry(fd, bytes)     pipe_write__return(fd, bytes written)
+//   pipe_read__entry(fd)             pipe_read__return(fd, bytes read)
+//   accept__entry(listen fd)         accept__return(fd)
+//   sem_wait__entry(sem)             sem_wait__return(sem, acquired)
+//   sem_post(sem)
+
+#if defined(PROCESS_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define PROCESS_TRACE_ENABLED 1
+#endif
+#endif
+
+#ifdef PROCESS_TRACE_ENABLED
+#define PROCESS_TRACE0(probe)            DTRACE_PROBE(process, probe)
+#define PROCESS_TRACE1(probe, a)         DTRACE_PROBE1(process, probe, a)
+#define PROCESS_TRACE2(probe, a, b)      DTRACE_PROBE2(process, probe, a, b)
+#else
+#define PROCESS_TRACE0(probe)            do {} while (0)
+#define PROCESS_TRACE1(probe, a)         do {} while (0)
+#define PROCESS_TRACE2(probe, a, b)      do {} while (0)
+#endif
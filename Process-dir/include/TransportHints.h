@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include "SocketChannel.h"
+
+enum class Transport : unsigned {
+    Pipe         = 1u << 0,
+    Socket       = 1u << 1,
+    SharedMemory = 1u << 2
+};
+
+constexpr unsigned operator|(Transport a, Transport b) {
+    return static_cast<unsigned>(a) | static_cast<unsigned>(b);
+}
+constexpr unsigned operator|(unsigned a, Transport b) {
+    return a | static_cast<unsigned>(b);
+}
+
+const char* to_string(Transport t);
+
+// What Process::startAuto() knows about the traffic. The child has to
+// speak whatever transport is chosen, so 'supported' lists the ones it
+// understands: plain stdio (Pipe), the socket client protocol, or the
+// shared-memory argv protocol.
+struct TransportHints {
+    std::size_t messageSize = 0;     // typical bytes per message
+    double messagesPerSecond = 0;    // expected rate, 0 if unknown
+    bool remote = false;             // peer may run on another host
+    unsigned supported = static_cast<unsigned>(Transport::Pipe);
+
+    unsigned short basePort = 0;     // used when a socket is chosen
+    SocketType socketType = SocketType::Unix;
+};
@@ -0,0 +1,133 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <bit>
+#include <thread>
+
+#include "Pipe.h"
+#include "SocketChannel.h"
+#include "SharedWorkQueue.h"
+
+// Identifies the in-memory layout of a record type: size, alignment, a
+// version the type may declare as 'static constexpr uint16_t channelVersion'
+// (default 0), and byte order. Two ends agree on a layout iff their tags are
+// equal; a header shared by both sides can pin it with
+//     static_assert(channel_layout_tag<Msg>() == <expected>);
+template <class T>
+constexpr std::uint64_t channel_layout_tag() {
+    std::uint64_t version = 0;
+    if constexpr (requires { T::channelVersion; }) {
+        static_assert(T::channelVersion <= 0xffff, "channelVersion must fit in 16 bits");
+        version = T::channelVersion;
+    }
+    static_assert(sizeof(T) <= 0xffffffffu, "record too large for a typed channel");
+    std::uint64_t order = std::endian::native == std::endian::little ? 0xC1 : 0xC2;
+    return (order << 56) | (version << 40) |
+           (static_cast<std::uint64_t>(alignof(T) & 0xff) << 32) | sizeof(T);
+}
+
+// Moves fixed-size records of a trivially copyable T as raw bytes: no
+// encoding, one copy into the transport and one out of it.
+//
+// Over a Pipe or SocketChannel the writer sends the layout tag once, ahead
+// of the first record, and the reader checks it before the first record it
+// returns, so binaries built from different definitions of T fail loudly
+// instead of misreading each other. Over a SharedWorkQueue the tag lives in
+// the queue header: use createQueue()/openQueue(), which also size the
+// slots to exactly sizeof(T).
+//
+// T must not contain pointers or handles; they are copied, not translated.
+template <class T>
+    requires std::is_trivially_copyable_v<T>
+class TypedChannel {
+    static_assert(!std::is_pointer_v<T>, "a raw pointer is meaningless in another process");
+
+public:
+    static constexpr std::uint64_t layoutTag = channel_layout_tag<T>();
+
+    explicit TypedChannel(Pipe& pipe) : kind(Kind::Pipe), pipe(&pipe) {}
+    explicit TypedChannel(SocketChannel& socket) : kind(Kind::Socket), socket(&socket) {}
+    explicit TypedChannel(SharedWorkQueue& queue) : kind(Kind::Queue), queue(&queue) {
+        if (queue.slotSize() != sizeof(T) || queue.tag() != layoutTag)
+            throw std::runtime_error("TypedChannel: queue was not created for this record type");
+    }
+
+    static bool createQueue(SharedWorkQueue& queue, const std::string& name, size_t capacity) {
+        return queue.create(name, capacity, sizeof(T), layoutTag);
+    }
+    static bool openQueue(SharedWorkQueue& queue, const std::string& name, size_t capacity) {
+        return queue.open(name, capacity, sizeof(T), layoutTag);
+    }
+
+    // Blocks until the record is handed to the transport; false if the
+    // other end is gone (for a queue: once it has been shut down).
+    bool send(const T& record) {
+        if (kind == Kind::Queue)
+            return queuePush(record);
+        return sendTag() && writeBytes(&record, sizeof(T));
+    }
+
+    // Pipes and sockets take the whole batch in one write.
+    bool sendMany(std::span<const T> records) {
+        if (kind == Kind::Queue) {
+            for (const T& r : records)
+                if (!queuePush(r)) return false;
+            return true;
+        }
+        return sendTag() && writeBytes(records.data(), records.size_bytes());
+    }
+
+    // Blocks for the next record; false on a clean end of stream. Throws if
+    // the writer's layout tag differs from ours, or if the stream ends in
+    // the middle of the tag or a record.
+    bool receive(T& record) {
+        if (kind == Kind::Queue)
+            return queue->pop(&record, sizeof(T)) == sizeof(T);
+        if (!tagChecked) {
+            std::uint64_t peer = 0;
+            if (!readWhole(&peer, sizeof(peer))) return false;
+            if (peer != layoutTag)
+                throw std::runtime_error("TypedChannel: peer record layout differs");
+            tagChecked = true;
+        }
+        return readWhole(&record, sizeof(T));
+    }
+
+private:
+    enum class Kind { Pipe, Socket, Queue };
+
+    bool sendTag() {
+        if (tagSent) return true;
+        std::uint64_t tag = layoutTag;
+        tagSent = writeBytes(&tag, sizeof(tag));
+        return tagSent;
+    }
+    bool writeBytes(const void* data, size_t len) {
+        return kind == Kind::Pipe ? pipe->writeBytes(data, len) : socket->writeBytes(data, len);
+    }
+    bool readWhole(void* out, size_t len) {
+        size_t got = 0;
+        bool ok = kind == Kind::Pipe ? pipe->readExact(out, len, &got) : socket->readExact(out, len, &got);
+        if (!ok && got != 0)
+            throw std::runtime_error("TypedChannel: stream ended inside a record");
+        return ok;
+    }
+    bool queuePush(const T& record) {
+        while (!queue->tryPush(&record, sizeof(T))) {
+            if (queue->isShutdown()) return false;
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    Kind kind;
+    Pipe* pipe = nullptr;
+    SocketChannel* socket = nullptr;
+    SharedWorkQueue* queue = nullptr;
+    bool tagSent = false;
+    bool tagChecked = false;
+};
@@ -0,0 +1,108 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <chrono>
+
+#include "Process.h"
+
+// Dispatches tasks to a pool of long-lived worker processes.
+//
+// Protocol: the parent writes one task per line to a worker's stdin, and
+// the worker answers each task with exactly one line on stdout, in order.
+//
+// Every worker has its own deque of queued tasks. A worker with a free
+// in-flight slot takes from the front of its own deque; when that is empty
+// it steals from the back of the longest other deque. Tasks only leave a
+// deque when written to a worker, so a backlog never sits behind one slow
+// task. If a worker dies, its in-flight tasks are queued again once
+// (maxAttempts), and its deque is left for the others to steal.
+class WorkerPool {
+public:
+    using TaskId = size_t;
+    using Clock = std::chrono::steady_clock;
+    static constexpr size_t anyWorker = static_cast<size_t>(-1);
+
+    struct TaskResult {
+        bool done = false;
+        bool ok = false;          // false: every attempt's worker died
+        std::string reply;
+        size_t worker = anyWorker;
+        unsigned attempts = 0;
+    };
+
+    struct WorkerStats {
+        size_t completed = 0;
+        size_t stolen = 0;        // tasks this worker took from another deque
+        size_t queued = 0;        // tasks still in its deque
+        size_t inFlight = 0;
+        size_t unsolicited = 0;   // stdout lines with no task in flight
+        bool alive = false;
+        Clock::duration busy{};   // time with at least one task in flight
+    };
+
+    WorkerPool(const std::string& path, const std::vector<std::string>& args,
+               size_t workers, const SpawnOptions& options = {});
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Tasks written to a worker before its reply (1: strictly one at a time).
+    void setDepth(size_t tasksPerWorker) { depth = tasksPerWorker ? tasksPerWorker : 1; }
+    void setMaxAttempts(unsigned attempts) { maxAttempts = attempts ? attempts : 1; }
+    void onComplete(std::function<void(TaskId, const TaskResult&)> callback) { completion = std::move(callback); }
+
+    void start();
+
+    // Queues a task (one line, no '\n') on the given worker's deque, or
+    // round-robin by default.
+    TaskId submit(std::string task, size_t worker = anyWorker);
+
+    // Dispatches until every submitted task has a result.
+    void run();
+
+    // Closes the workers' stdin and reaps them.
+    void shutdown();
+
+    const TaskResult& result(TaskId id) const { return results.at(id); }
+    size_t size() const { return workers.size(); }
+    WorkerStats stats(size_t worker) const;
+    // The last 64 KiB of a worker's stderr, interleaved with any stdout
+    // lines it printed while no task was in flight.
+    const std::string& errorOutput(size_t worker) const { return workers.at(worker).errors; }
+
+private:
+    struct Worker {
+        std::unique_ptr<Process> proc;
+        std::deque<TaskId> queue;        // not yet sent
+        std::deque<TaskId> inFlight;     // sent, replies arrive in this order
+        std::string outbound;            // bytes not yet accepted by the pipe
+        std::string inbound;             // partial reply line
+        std::string errors;              // last 64 KiB of stderr and stray stdout
+        bool alive = false;
+        size_t completed = 0;
+        size_t unsolicited = 0;
+        size_t stolen = 0;
+        Clock::time_point busySince{};
+        Clock::duration busy{};
+    };
+
+    std::string executable;
+    std::vector<std::string> arguments;
+    SpawnOptions options;
+    size_t depth = 1;
+    unsigned maxAttempts = 2;
+    size_t nextWorker = 0;
+    size_t pending = 0;                  // submitted tasks without a result
+
+    std::vector<Worker> workers;
+    std::vector<std::string> tasks;
+    std::vector<TaskResult> results;
+    std::function<void(TaskId, const TaskResult&)> completion;
+
+    bool refill(size_t w);
+    void finish(TaskId id, size_t w, bool ok, std::string reply);
+    void workerDied(size_t w);
+};
@@ -0,0 +1,231 @@
+// This is a demo version of PVS-Studio for educational use.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: https://pvs-studio.com
+#include "../include/ChannelCounters.h"
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <sys/uio.h>
+#include <climits>
+#include <cerrno>
+#endif
+
+namespace {
+
+// Live instances plus the folded totals of destroyed ones. Labels live
+// here rather than in the counters so the hot path stays free of locks.
+struct CounterRegistry {
+    std::mutex mtx;
+    std::unordered_map<const ChannelCounters*, std::string> live;
+    ChannelStats retired[4];
+
+    static CounterRegistry& instance() {
+        static CounterRegistry registry;
+        return registry;
+    }
+};
+
+void json_string(std::ostringstream& out, const std::string& s) {
+    out << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20) out << ' ';
+        else out << c;
+    }
+    out << '"';
+}
+
+void json_stats(std::ostringstream& out, const ChannelStats& s) {
+    out << "{\"bytesIn\":" << s.bytesIn
+        << ",\"bytesOut\":" << s.bytesOut
+        << ",\"messagesIn\":" << s.messagesIn
+        << ",\"messagesOut\":" << s.messagesOut
+        << ",\"syscalls\":" << s.syscalls
+        << ",\"shortWrites\":" << s.shortWrites
+        << ",\"wouldBlock\":" << s.wouldBlock
+        << ",\"waits\":" << s.waits
+        << ",\"waitNanos\":" << s.waitNanos << "}";
+}
+
+void text_stats(std::ostringstream& out, const ChannelStats& s) {
+    out << "in=" << s.bytesIn << "B/" << s.messagesIn
+        << " out=" << s.bytesOut << "B/" << s.messagesOut
+        << " syscalls=" << s.syscalls
+        << " short=" << s.shortWrites
+        << " eagain=" << s.wouldBlock
+        << " waits=" << s.waits
+        << " waited=" << s.waitNanos / 1000 << "us";
+}
+
+}
+
+const char* to_string(ChannelKind kind) {
+    switch (kind) {
+    case ChannelKind::Pipe:         return "pipe";
+    case ChannelKind::Socket:       return "socket";
+    case ChannelKind::SharedMemory: return "shm";
+    case ChannelKind::Semaphore:    return "semaphore";
+    }
+    return "unknown";
+}
+
+ChannelStats& ChannelStats::operator+=(const ChannelStats& o) {
+    bytesIn += o.bytesIn;
+    bytesOut += o.bytesOut;
+    messagesIn += o.messagesIn;
+    messagesOut += o.messagesOut;
+    syscalls += o.syscalls;
+    shortWrites += o.shortWrites;
+    wouldBlock += o.wouldBlock;
+    waits += o.waits;
+    waitNanos += o.waitNanos;
+    return *this;
+}
+
+ChannelCounters::ChannelCounters(ChannelKind kind) : channelKind(kind) {
+    CounterRegistry& r = CounterRegistry::instance();
+    std::lock_guard<std::mutex> lock(r.mtx);
+    r.live.emplace(this, std::string());
+}
+
+ChannelCounters::~ChannelCounters() {
+    CounterRegistry& r = CounterRegistry::instance();
+    std::lock_guard<std::mutex> lock(r.mtx);
+    r.live.erase(this);
+    r.retired[static_cast<int>(channelKind)] += snapshot();
+}
+
+ChannelStats ChannelCounters::snapshot() const {
+    ChannelStats s;
+    s.bytesIn     = bytesIn.load(std::memory_order_relaxed);
+    s.bytesOut    = bytesOut.load(std::memory_order_relaxed);
+    s.messagesIn  = messagesIn.load(std::memory_order_relaxed);
+    s.messagesOut = messagesOut.load(std::memory_order_relaxed);
+    s.syscalls    = syscalls.load(std::memory_order_relaxed);
+    s.shortWrites = shortWrites.load(std::memory_order_relaxed);
+    s.wouldBlock  = wouldBlock.load(std::memory_order_relaxed);
+    s.waits       = waits.load(std::memory_order_relaxed);
+    s.waitNanos   = waitNanos.load(std::memory_order_relaxed);
+    return s;
+}
+
+void ChannelCounters::reset() {
+    for (auto* c : { &bytesIn, &bytesOut, &messagesIn, &messagesOut, &syscalls,
+                     &shortWrites, &wouldBlock, &waits, &waitNanos })
+        c->store(0, std::memory_order_relaxed);
+}
+
+void ChannelCounters::setLabel(std::string text) {
+    CounterRegistry& r = CounterRegistry::instance();
+    std::lock_guard<std::mutex> lock(r.mtx);
+    r.live[this] = std::move(text);
+}
+
+std::string ChannelCounters::label() const {
+    CounterRegistry& r = CounterRegistry::instance();
+    std::lock_guard<std::mutex> lock(r.mtx);
+    auto it = r.live.find(this);
+    return it == r.live.end() ? std::string() : it->second;
+}
+
+namespace ipc {
+
+MetricsSnapshot metrics() {
+    MetricsSnapshot m;
+    CounterRegistry& r = CounterRegistry::instance();
+    std::lock_guard<std::mutex> lock(r.mtx);
+
+    for (int k = 0; k < 4; k++)
+        m.totals[k] = r.retired[k];
+
+    m.channels.reserve(r.live.size());
+    for (auto& [counters, label] : r.live) {
+        ChannelMetrics c{ counters->kind(), label, counters->snapshot() };
+        m.totals[static_cast<int>(c.kind)] += c.stats;
+        m.channels.push_back(std::move(c));
+    }
+    return m;
+}
+
+std::string MetricsSnapshot::toText() const {
+    std::ostringstream out;
+    for (int k = 0; k < 4; k++) {
+        out << "total " << to_string(static_cast<ChannelKind>(k)) << ": ";
+        text_stats(out, totals[k]);
+        out << "\n";
+    }
+    for (auto& c : channels) {
+        // Idle unlabelled channels (unused Process members) are noise.
+        if (c.label.empty() && c.stats.messagesIn == 0 && c.stats.messagesOut == 0 && c.stats.waits == 0)
+            continue;
+        out << to_string(c.kind) << " " << (c.label.empty() ? "-" : c.label) << ": ";
+        text_stats(out, c.stats);
+        out << "\n";
+    }
+    return out.str();
+}
+
+std::string MetricsSnapshot::toJson() const {
+    std::ostringstream out;
+    out << "{\"totals\":{";
+    for (int k = 0; k < 4; k++) {
+        if (k) out << ",";
+        out << "\"" << to_string(static_cast<ChannelKind>(k)) << "\":";
+        json_stats(out, totals[k]);
+    }
+    out << "},\"channels\":[";
+    for (size_t i = 0; i < channels.size(); i++) {
+        if (i) out << ",";
+        out << "{\"kind\":\"" << to_string(channels[i].kind) << "\",\"label\":";
+        json_string(out, channels[i].label);
+        out << ",\"stats\":";
+        json_stats(out, channels[i].stats);
+        out << "}";
+    }
+    out << "]}";
+    return out.str();
+}
+
+}
+
+#ifndef _WIN32
+std::size_t write_records(int fd, std::span<const std::string_view> records,
+                          ChannelCounters& counters) {
+    std::vector<iovec> iov;
+    iov.reserve((std::min)(records.size(), static_cast<std::size_t>(IOV_MAX)));
+    std::size_t next = 0;
+    std::size_t offset = 0;  // bytes of records[next] already written
+    std::size_t total = 0;
+    while (next < records.size()) {
+        iov.clear();
+        std::size_t want = 0;
+        for (std::size_t i = next; i < records.size() && iov.size() < IOV_MAX; i++) {
+            std::size_t skip = i == next ? offset : 0;
+            if (records[i].size() == skip) continue;
+            iov.push_back({ const_cast<char*>(records[i].data()) + skip, records[i].size() - skip });
+            want += records[i].size() - skip;
+        }
+        if (iov.empty()) break;
+
+        ssize_t n = ::writev(fd, iov.data(), static_cast<int>(iov.size()));
+        counters.syscall();
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) counters.blocked();
+        if (n <= 0) break;
+
+        std::size_t done = static_cast<std::size_t>(n);
+        total += done;
+        if (done < want) counters.shortWrite();
+        while (next < records.size() && done >= records[next].size() - offset) {
+            done -= records[next].size() - offset;
+            offset = 0;
+            next++;
+        }
+        offset += done;
+    }
+    counters.wrote(total);
+    return total;
+}
+#endif
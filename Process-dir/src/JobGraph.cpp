@@ -0,0 +1,454 @@
+// This is a demo version of PVS-Studio for educational use.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: https://pvs-studio.com
+#include "../include/JobGraph.h"
+#include "../include/SigpipeGuard.h"
+#include <stdexcept>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <thread>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <cerrno>
+#endif
+
+struct JobGraph::Node {
+    std::string name;
+    std::string path;
+    std::vector<std::string> args;
+    SpawnOptions options;
+    std::string input;
+
+    std::vector<NodeId> dataIn;    // producers feeding stdin, in edge order
+    std::vector<NodeId> orderIn;   // must succeed before this node starts
+    std::vector<NodeId> dataOut;   // consumers of this node's stdout
+    bool keepStdout = false;
+
+    std::unique_ptr<Process> proc;
+    NodeResult result;
+    bool started = false;
+    bool reaped = false;
+    bool stdinOpen = false;
+    bool stdoutOpen = false;
+    bool stderrOpen = false;
+    bool stalled = false;          // stdout backlog is at the edge buffer
+
+    // Stream offset of result.stdoutData[0]; what lies before it has been
+    // fed to every consumer and released.
+    size_t stdoutBase = 0;
+
+    // Position in the stdin feed: 0 is 'input', i > 0 is dataIn[i - 1].
+    // feedOffset counts from the start of that source's whole stream.
+    size_t feedIndex = 0;
+    size_t feedOffset = 0;
+
+    bool outputComplete() const {
+        return result.state == NodeState::Skipped || (started && !stdoutOpen);
+    }
+    bool done() const {
+        return result.state == NodeState::Skipped || (reaped && !stdoutOpen && !stderrOpen);
+    }
+};
+
+JobGraph::JobGraph() = default;
+JobGraph::~JobGraph() = default;
+
+JobGraph::NodeId JobGraph::add(const std::string& name, const std::string& path,
+                               const std::vector<std::string>& args, const SpawnOptions& options) {
+    auto n = std::make_unique<Node>();
+    n->name = name;
+    n->path = path;
+    n->args = args;
+    n->options = options;
+    nodes.push_back(std::move(n));
+    return nodes.size() - 1;
+}
+
+void JobGraph::setInput(NodeId node, std::string data) {
+    nodes.at(node)->input = std::move(data);
+}
+
+void JobGraph::pipe(NodeId from, NodeId to) {
+    nodes.at(to)->dataIn.push_back(from);
+    nodes.at(from)->dataOut.push_back(to);
+}
+
+void JobGraph::keepStdout(NodeId node, bool keep) {
+    nodes.at(node)->keepStdout = keep;
+}
+
+void JobGraph::after(NodeId before, NodeId node) {
+    nodes.at(before);
+    nodes.at(node)->orderIn.push_back(before);
+}
+
+const std::string& JobGraph::name(NodeId node) const {
+    return nodes.at(node)->name;
+}
+
+const JobGraph::NodeResult& JobGraph::result(NodeId node) const {
+    return nodes.at(node)->result;
+}
+
+std::vector<JobGraph::NodeId> JobGraph::topologicalOrder() const {
+    std::vector<size_t> pending(nodes.size());
+    std::vector<std::vector<NodeId>> successors(nodes.size());
+    for (NodeId i = 0; i < nodes.size(); i++) {
+        for (NodeId p : nodes[i]->dataIn)  successors[p].push_back(i);
+        for (NodeId p : nodes[i]->orderIn) successors[p].push_back(i);
+        pending[i] = nodes[i]->dataIn.size() + nodes[i]->orderIn.size();
+    }
+
+    std::vector<NodeId> order;
+    for (NodeId i = 0; i < nodes.size(); i++)
+        if (pending[i] == 0) order.push_back(i);
+    for (size_t k = 0; k < order.size(); k++)
+        for (NodeId s : successors[order[k]])
+            if (--pending[s] == 0) order.push_back(s);
+
+    if (order.size() != nodes.size())
+        throw std::runtime_error("JobGraph contains a cycle");
+    return order;
+}
+
+#ifdef _WIN32
+
+bool JobGraph::run() {
+    throw std::runtime_error("JobGraph::run requires poll(); not supported on Windows");
+}
+
+#else
+
+namespace {
+
+enum class Ready { No, Yes, Skip };
+
+constexpr size_t NOT_NEEDED = static_cast<size_t>(-1);
+
+// Released stdout is only erased in chunks of at least this size, so the
+// buffer is not shifted for every small write a consumer accepts.
+constexpr size_t RELEASE_CHUNK = 64 * 1024;
+
+}
+
+bool JobGraph::run() {
+    std::vector<NodeId> order = topologicalOrder();
+    size_t limit = concurrency ? concurrency : (std::max)(1u, std::thread::hardware_concurrency());
+
+    // Feeding a consumer that already exited must fail with EPIPE rather
+    // than kill the parent.
+    SigpipeGuard sigpipeGuard;
+    runStarted = Clock::now();
+    for (auto& n : nodes) {
+        n->proc.reset();
+        n->result = NodeResult{};
+        n->started = n->reaped = false;
+        n->stdinOpen = n->stdoutOpen = n->stderrOpen = n->stalled = false;
+        n->stdoutBase = n->feedIndex = n->feedOffset = 0;
+    }
+
+    auto readiness = [&](const Node& n) {
+        for (NodeId p : n.orderIn) {
+            NodeState s = nodes[p]->result.state;
+            if (s == NodeState::Failed || s == NodeState::Skipped) return Ready::Skip;
+            if (s != NodeState::Succeeded) return Ready::No;
+        }
+        for (NodeId p : n.dataIn) {
+            const Node& src = *nodes[p];
+            if (src.result.state == NodeState::Skipped) return Ready::Skip;
+            if (src.result.state == NodeState::Failed) return Ready::Skip;
+            if (!src.started) return Ready::No;
+        }
+        return Ready::Yes;
+    };
+
+    // Where consumer c stands in producer p's stdout: the stream offset it
+    // has been fed up to, 0 if it has not reached p yet, or NOT_NEEDED.
+    auto positionIn = [&](const Node& c, NodeId p) {
+        if (c.result.state == NodeState::Skipped || (c.started && !c.stdinOpen))
+            return NOT_NEEDED;
+        size_t pos = NOT_NEEDED;
+        for (size_t k = 0; k < c.dataIn.size(); k++) {
+            if (c.dataIn[k] != p || k + 1 < c.feedIndex) continue;
+            pos = (std::min)(pos, k + 1 == c.feedIndex ? c.feedOffset : size_t(0));
+        }
+        return pos;
+    };
+
+    // Release what every consumer of p has been fed, and stall p while a
+    // consumer reading it right now lags a full edge buffer behind. Only
+    // such a consumer may hold p back: one still waiting for an earlier
+    // input could be waiting on p's other consumers, which would deadlock.
+    auto applyBackpressure = [&](NodeId p) {
+        Node& n = *nodes[p];
+        size_t end = n.stdoutBase + n.result.stdoutData.size();
+        size_t needed = NOT_NEEDED, reading = NOT_NEEDED;
+        for (NodeId c : n.dataOut) {
+            const Node& consumer = *nodes[c];
+            size_t pos = positionIn(consumer, p);
+            needed = (std::min)(needed, pos);
+            if (consumer.started && consumer.stdinOpen && consumer.feedIndex > 0
+                && consumer.dataIn[consumer.feedIndex - 1] == p)
+                reading = (std::min)(reading, consumer.feedOffset);
+        }
+        n.stalled = reading != NOT_NEEDED && end - reading >= edgeBuffer;
+
+        if (n.keepStdout) return;
+        size_t release = (std::min)(needed, end) - n.stdoutBase;
+        if (release >= RELEASE_CHUNK || (release > 0 && release == n.result.stdoutData.size())) {
+            n.result.stdoutData.erase(0, release);
+            n.stdoutBase += release;
+        }
+    };
+
+    // The source n is currently fed from and that source's stream offset.
+    auto feedSource = [&](const Node& n) -> std::pair<const std::string*, size_t> {
+        if (n.feedIndex == 0) return { &n.input, 0 };
+        const Node& p = *nodes[n.dataIn[n.feedIndex - 1]];
+        return { &p.result.stdoutData, p.stdoutBase };
+    };
+
+    auto finishReap = [&](Node& n) {
+        n.reaped = true;
+        n.result.finished = Clock::now();
+        n.result.status = n.proc->exitStatus();
+        n.result.stats = n.proc->stats();
+        n.result.state = n.result.status.exited && n.result.status.code == 0
+                             ? NodeState::Succeeded : NodeState::Failed;
+        if (n.stdinOpen) {
+            n.proc->closeStdin();
+            n.stdinOpen = false;
+        }
+    };
+
+    size_t running = 0;
+    std::vector<pollfd> fds;
+    enum class Slot { Stdin, Stdout, Stderr, Exit };
+    std::vector<std::pair<NodeId, Slot>> owners;
+
+    for (;;) {
+        // 1. Start or skip whatever has become ready, upstream first so
+        //    skips cascade within one pass.
+        for (NodeId id : order) {
+            Node& n = *nodes[id];
+            if (n.started || n.result.state == NodeState::Skipped) continue;
+            Ready r = readiness(n);
+            if (r == Ready::Skip) {
+                n.result.state = NodeState::Skipped;
+                continue;
+            }
+            if (r == Ready::No || running >= limit) continue;
+
+            n.proc = std::make_unique<Process>(n.path, n.args, n.options);
+            n.started = true;
+            n.result.started = Clock::now();
+            try {
+                n.proc->start();
+            } catch (const std::exception& e) {
+                n.result.stderrData = e.what();
+                n.result.finished = n.result.started;
+                n.result.state = NodeState::Failed;
+                n.reaped = true;
+                continue;
+            }
+            n.proc->stdinStream().setNonBlocking(true);
+            n.proc->stdoutStream().setNonBlocking(true);
+            n.proc->stderrStream().setNonBlocking(true);
+            n.stdinOpen = n.stdoutOpen = n.stderrOpen = true;
+            running++;
+        }
+
+        // 2. Move each consumer's feed past finished sources; close its
+        //    stdin once every source is drained.
+        for (auto& np : nodes) {
+            Node& n = *np;
+            if (!n.stdinOpen) continue;
+            while (n.feedIndex <= n.dataIn.size()) {
+                auto [src, base] = feedSource(n);
+                bool complete = n.feedIndex == 0
+                    || nodes[n.dataIn[n.feedIndex - 1]]->outputComplete();
+                if (n.feedOffset < base + src->size() || !complete) break;
+                n.feedIndex++;
+                n.feedOffset = 0;
+            }
+            if (n.feedIndex > n.dataIn.size()) {
+                n.proc->closeStdin();
+                n.stdinOpen = false;
+            }
+        }
+
+        if (std::all_of(nodes.begin(), nodes.end(), [](auto& n) { return n->done(); }))
+            break;
+
+        for (NodeId id = 0; id < nodes.size(); id++)
+            if (!nodes[id]->dataOut.empty())
+                applyBackpressure(id);
+
+        // 3. Wait for output, room in a consumer's pipe, or an exit.
+        fds.clear();
+        owners.clear();
+        bool needsPolling = false;
+        for (NodeId id = 0; id < nodes.size(); id++) {
+            Node& n = *nodes[id];
+            if (!n.started || !n.proc) continue;
+            if (n.stdoutOpen && !n.stalled) {
+                fds.push_back({ n.proc->stdoutStream().getReadFD(), POLLIN, 0 });
+                owners.push_back({ id, Slot::Stdout });
+            }
+            if (n.stderrOpen) {
+                fds.push_back({ n.proc->stderrStream().getReadFD(), POLLIN, 0 });
+                owners.push_back({ id, Slot::Stderr });
+            }
+            if (n.stdinOpen && n.feedIndex <= n.dataIn.size()) {
+                auto [src, base] = feedSource(n);
+                if (n.feedOffset < base + src->size()) {
+                    fds.push_back({ n.proc->stdinStream().getWriteFD(), POLLOUT, 0 });
+                    owners.push_back({ id, Slot::Stdin });
+                }
+            }
+            if (!n.reaped) {
+                if (n.proc->getPidFD() != -1) {
+                    fds.push_back({ n.proc->getPidFD(), POLLIN, 0 });
+                    owners.push_back({ id, Slot::Exit });
+                } else {
+                    needsPolling = true;
+                }
+            }
+        }
+        if (fds.empty() && !needsPolling)
+            continue;
+
+        int r = ::poll(fds.data(), fds.size(), needsPolling ? 10 : -1);
+        if (r < 0 && errno != EINTR)
+            throw std::runtime_error("JobGraph poll failed");
+
+        // 4. Service what is ready.
+        for (size_t i = 0; r > 0 && i < fds.size(); i++) {
+            if (!fds[i].revents) continue;
+            Node& n = *nodes[owners[i].first];
+            switch (owners[i].second) {
+            case Slot::Stdout: {
+                long got = n.proc->stdoutStream().readSome(n.result.stdoutData);
+                if (got > 0)
+                    n.result.stdoutBytes += static_cast<std::uint64_t>(got);
+                if (got == 0 || (got < 0 && errno != EAGAIN)) {
+                    n.proc->stdoutStream().closeRead();
+                    n.stdoutOpen = false;
+                }
+                break;
+            }
+            case Slot::Stderr: {
+                long got = n.proc->stderrStream().readSome(n.result.stderrData);
+                if (got == 0 || (got < 0 && errno != EAGAIN)) {
+                    n.proc->stderrStream().closeRead();
+                    n.stderrOpen = false;
+                }
+                break;
+            }
+            case Slot::Stdin: {
+                auto [src, base] = feedSource(n);
+                long put = n.proc->stdinStream().writeSome(
+                    std::string_view(*src).substr(n.feedOffset - base));
+                if (put > 0) {
+                    n.feedOffset += static_cast<size_t>(put);
+                } else if (put < 0 && errno != EAGAIN) {
+                    // The consumer closed its stdin (or exited); drop the rest.
+                    n.proc->closeStdin();
+                    n.stdinOpen = false;
+                }
+                break;
+            }
+            case Slot::Exit:
+                if (!n.reaped && n.proc->tryWait()) {
+                    finishReap(n);
+                    running--;
+                }
+                break;
+            }
+        }
+
+        if (needsPolling) {
+            for (auto& np : nodes) {
+                Node& n = *np;
+                if (n.started && n.proc && !n.reaped && n.proc->getPidFD() == -1 && n.proc->tryWait()) {
+                    finishReap(n);
+                    running--;
+                }
+            }
+        }
+    }
+
+    return std::all_of(nodes.begin(), nodes.end(),
+                       [](auto& n) { return n->result.state == NodeState::Succeeded; });
+}
+
+#endif
+
+std::vector<JobGraph::NodeId> JobGraph::criticalPath() const {
+    std::vector<NodeId> order = topologicalOrder();
+    std::vector<Clock::duration> best(nodes.size(), Clock::duration::zero());
+    std::vector<NodeId> via(nodes.size(), static_cast<NodeId>(-1));
+
+    for (NodeId id : order) {
+        const Node& n = *nodes[id];
+        Clock::duration upstream = Clock::duration::zero();
+        for (const auto* preds : { &n.dataIn, &n.orderIn }) {
+            for (NodeId p : *preds) {
+                if (via[id] == static_cast<NodeId>(-1) || best[p] > upstream) {
+                    upstream = best[p];
+                    via[id] = p;
+                }
+            }
+        }
+        Clock::duration own = n.started ? n.result.wallTime() : Clock::duration::zero();
+        best[id] = upstream + own;
+    }
+
+    std::vector<NodeId> path;
+    if (nodes.empty()) return path;
+    NodeId last = static_cast<NodeId>(std::max_element(best.begin(), best.end()) - best.begin());
+    for (NodeId at = last; at != static_cast<NodeId>(-1); at = via[at])
+        path.push_back(at);
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+JobGraph::Clock::duration JobGraph::criticalPathTime() const {
+    Clock::duration total = Clock::duration::zero();
+    for (NodeId id : criticalPath())
+        if (nodes[id]->started)
+            total += nodes[id]->result.wallTime();
+    return total;
+}
+
+std::string JobGraph::report() const {
+    static const char* names[] = { "pending", "ok", "failed", "skipped" };
+    auto ms = [](Clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    };
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    for (const auto& np : nodes) {
+        const Node& n = *np;
+        out << std::left << std::setw(16) << n.name << std::right
+            << std::setw(8) << names[static_cast<int>(n.result.state)];
+        if (n.started) {
+            out << "  start +" << ms(n.result.started - runStarted) << " ms"
+                << "  wall " << ms(n.result.wallTime()) << " ms"
+                << "  cpu " << (n.result.stats.userCpuSeconds + n.result.stats.systemCpuSeconds) * 1000 << " ms";
+            if (n.result.status.exited)
+                out << "  exit " << n.result.status.code;
+            else if (n.result.status.signal)
+                out << "  signal " << n.result.status.signal;
+        }
+        out << "\n";
+    }
+
+    out << "critical path (" << ms(criticalPathTime()) << " ms):";
+    for (NodeId id : criticalPath())
+        out << " " << nodes[id]->name;
+    out << "\n";
+    return out.str();
+}
@@ -0,0 +1,204 @@
+// This is a demo version of PVS-Studio for educational use.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: https://pvs-studio.com
+#include "../include/OutputSpool.h"
+#include <stdexcept>
+#include <cstdlib>
+#include <vector>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+OutputSpool::OutputSpool(size_t limit, std::string spillDirectory)
+    : memoryLimit(limit), directory(std::move(spillDirectory)) {
+    if (directory.empty()) {
+#ifdef _WIN32
+        char buf[MAX_PATH + 1];
+        DWORD n = GetTempPathA(sizeof(buf), buf);
+        directory = n ? std::string(buf, n) : ".";
+#else
+        const char* tmp = std::getenv("TMPDIR");
+        directory = tmp && *tmp ? tmp : "/tmp";
+#endif
+    }
+}
+
+OutputSpool::~OutputSpool() {
+    clear();
+}
+
+void OutputSpool::clear() {
+    unmap();
+    if (spillFile != invalidFile) {
+#ifdef _WIN32
+        CloseHandle(spillFile);
+#else
+        ::close(spillFile);
+#endif
+        spillFile = invalidFile;
+    }
+    memory.clear();
+    memory.shrink_to_fit();
+    total = 0;
+}
+
+void OutputSpool::unmap() {
+    if (!mapped) return;
+#ifdef _WIN32
+    UnmapViewOfFile(mapped);
+    CloseHandle(mapping);
+    mapping = nullptr;
+#else
+    munmap(mapped, mappedSize);
+#endif
+    mapped = nullptr;
+    mappedSize = 0;
+}
+
+// Moves the in-memory prefix into a fresh nameless file; the heap buffer
+// is released rather than kept around at its high-water mark.
+void OutputSpool::spill() {
+#ifdef _WIN32
+    char path[MAX_PATH + 1];
+    if (!GetTempFileNameA(directory.c_str(), "spl", 0, path))
+        throw std::runtime_error("OutputSpool: GetTempFileName failed");
+    spillFile = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                            FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+    if (spillFile == INVALID_HANDLE_VALUE) {
+        spillFile = invalidFile;
+        throw std::runtime_error("OutputSpool: cannot create spill file");
+    }
+#else
+    int fd = -1;
+#ifdef O_TMPFILE
+    fd = ::open(directory.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+#endif
+    if (fd == -1) {
+        std::string templ = directory + "/spool_XXXXXX";
+        std::vector<char> name(templ.begin(), templ.end());
+        name.push_back('\0');
+        fd = ::mkstemp(name.data());
+        if (fd == -1)
+            throw std::runtime_error("OutputSpool: cannot create spill file in " + directory);
+        ::unlink(name.data());
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    spillFile = fd;
+#endif
+
+    std::string pending;
+    pending.swap(memory);
+    writeFile(pending.data(), pending.size());
+}
+
+void OutputSpool::writeFile(const char* data, size_t len) {
+#ifdef _WIN32
+    while (len > 0) {
+        DWORD chunk = static_cast<DWORD>(len > (1u << 30) ? (1u << 30) : len);
+        DWORD written = 0;
+        if (!WriteFile(spillFile, data, chunk, &written, nullptr) || written == 0)
+            throw std::runtime_error("OutputSpool: write to spill file failed");
+        data += written;
+        len -= written;
+    }
+#else
+    while (len > 0) {
+        ssize_t n = ::write(spillFile, data, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0)
+            throw std::runtime_error("OutputSpool: write to spill file failed");
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+#endif
+}
+
+void OutputSpool::append(const char* data, size_t len) {
+    if (len == 0) return;
+    if (!spilled() && memory.size() + len > memoryLimit)
+        spill();
+
+    if (spilled())
+        writeFile(data, len);
+    else
+        memory.append(data, len);
+    total += len;
+}
+
+#ifndef _WIN32
+std::uint64_t OutputSpool::readFrom(int fd) {
+    std::uint64_t before = total;
+    if (fd == -1) return 0;
+
+    char buf[65536];
+#ifdef __linux__
+    bool trySplice = true;
+#endif
+    for (;;) {
+#ifdef __linux__
+        // Spilled: move pages from the pipe into the file without copying
+        // them through user space. EINVAL means fd is not a pipe; fall back
+        // to read() for the rest of the stream. EAGAIN ends the read like
+        // it does for read(); anything else is a failed write to the spill
+        // file or a broken fd, and must not pass for EOF.
+        if (trySplice && spilled()) {
+            ssize_t n = ::splice(fd, nullptr, spillFile, nullptr, 1 << 20, SPLICE_F_MOVE);
+            if (n > 0) {
+                total += static_cast<std::uint64_t>(n);
+                continue;
+            }
+            if (n == 0) break;
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) break;
+            if (errno != EINVAL)
+                throw std::runtime_error(std::string("OutputSpool: splice to spill file failed: ") +
+                                         std::strerror(errno));
+            trySplice = false;
+        }
+#endif
+        ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        append(buf, static_cast<size_t>(n));
+    }
+    return total - before;
+}
+#endif
+
+std::string_view OutputSpool::view() {
+    if (!spilled())
+        return std::string_view(memory);
+    if (total == 0)
+        return {};
+
+    if (mapped && mappedSize == total)
+        return std::string_view(static_cast<const char*>(mapped), static_cast<size_t>(total));
+
+    unmap();
+#ifdef _WIN32
+    mapping = CreateFileMappingA(spillFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+        throw std::runtime_error("OutputSpool: CreateFileMapping failed");
+    mapped = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!mapped) {
+        CloseHandle(mapping);
+        mapping = nullptr;
+        throw std::runtime_error("OutputSpool: MapViewOfFile failed");
+    }
+#else
+    void* p = mmap(nullptr, static_cast<size_t>(total), PROT_READ, MAP_SHARED, spillFile, 0);
+    if (p == MAP_FAILED)
+        throw std::runtime_error("OutputSpool: mmap of spill file failed");
+    mapped = p;
+#endif
+    mappedSize = total;
+    return std::string_view(static_cast<const char*>(mapped), static_cast<size_t>(total));
+}
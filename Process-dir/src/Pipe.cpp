@@ -2,14 +2,17 @@
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: https://pvs-studio.com
 
 #include "../include/Pipe.h"
+#include "../include/Tracing.h"
 #include <stdexcept>
 #include <vector>
+#include <algorithm>
 
 #ifdef _WIN32
 #include <windows.h>
 #else
 #include <unistd.h>
 #include <fcntl.h>
+#include <cerrno>
 #endif
 
 Pipe::Pipe() = default;
@@ -20,6 +23,9 @@ Pipe::~Pipe() {
 }
 
 bool Pipe::create() {
+    closeRead();
+    closeWrite();
+
 #ifdef _WIN32
     SECURITY_ATTRIBUTES saAttr{};
     saAttr.nLength = sizeof(SECURITY_ATTRIBUTES);
@@ -32,8 +38,16 @@ bool Pipe::create() {
     return true;
 
 #else
+    // Close-on-exec, so the pipe never leaks into unrelated children;
+    // Process dup2()s the ends a child needs onto its stdio.
     int fds[2];
+#ifdef __linux__
+    if (::pipe2(fds, O_CLOEXEC) < 0) return false;
+#else
     if (::pipe(fds) < 0) return false;
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#endif
     readFD = fds[0];
     writeFD = fds[1];
 
@@ -75,25 +89,233 @@ std::string Pipe::readAll() {
     if (!hRead) return result;
     char buffer[4096];
     DWORD bytesRead;
-    while (ReadFile(hRead, buffer, sizeof(buffer), &bytesRead, nullptr) && bytesRead > 0)
+    while (ReadFile(hRead, buffer, sizeof(buffer), &bytesRead, nullptr) && bytesRead > 0) {
+        channelCounters.syscall();
         result.append(buffer, bytesRead);
+    }
+    channelCounters.syscall();
 #else
     if (readFD == -1) return result;
+    PROCESS_TRACE1(pipe_read__entry, readFD);
     char buffer[4096];
     ssize_t bytes;
-    while ((bytes = ::read(readFD, buffer, sizeof(buffer))) > 0)
+    for (;;) {
+        bytes = ::read(readFD, buffer, sizeof(buffer));
+        channelCounters.syscall();
+        if (bytes < 0 && errno == EINTR) continue;
+        if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) channelCounters.blocked();
+        if (bytes <= 0) break;
         result.append(buffer, bytes);
+    }
+    PROCESS_TRACE2(pipe_read__return, readFD, result.size());
 #endif
+    channelCounters.read(result.size());
     return result;
 }
 
+std::uint64_t Pipe::readAllTo(OutputSpool& spool) {
+    std::uint64_t got = 0;
+#ifdef _WIN32
+    if (!hRead) return 0;
+    char buffer[65536];
+    DWORD bytesRead;
+    while (ReadFile(hRead, buffer, sizeof(buffer), &bytesRead, nullptr) && bytesRead > 0) {
+        channelCounters.syscall();
+        spool.append(buffer, bytesRead);
+        got += bytesRead;
+    }
+    channelCounters.syscall();
+#else
+    if (readFD == -1) return 0;
+    PROCESS_TRACE1(pipe_read__entry, readFD);
+    got = spool.readFrom(readFD);
+    PROCESS_TRACE2(pipe_read__return, readFD, got);
+#endif
+    channelCounters.read(got);
+    return got;
+}
+
 void Pipe::write(const std::string& data) {
 #ifdef _WIN32
     if (!hWrite) return;
-    DWORD written;
+    DWORD written = 0;
     WriteFile(hWrite, data.c_str(), static_cast<DWORD>(data.size()), &written, nullptr);
+    channelCounters.syscall();
+    if (written < data.size()) channelCounters.shortWrite();
+    channelCounters.wrote(written);
+#else
+    if (writeFD == -1) return;
+    PROCESS_TRACE2(pipe_write__entry, writeFD, data.size());
+    const char* p = data.data();
+    size_t left = data.size();
+    while (left > 0) {
+        ssize_t n = ::write(writeFD, p, left);
+        channelCounters.syscall();
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) channelCounters.blocked();
+        if (n <= 0) break;
+        if (static_cast<size_t>(n) < left) channelCounters.shortWrite();
+        left -= static_cast<size_t>(n);
+        p += n;
+    }
+    channelCounters.wrote(data.size() - left);
+    PROCESS_TRACE2(pipe_write__return, writeFD, data.size() - left);
+#endif
+}
+
+long Pipe::readSome(std::string& out, size_t maxBytes) {
+    size_t old = out.size();
+    out.resize(old + maxBytes);
+#ifdef _WIN32
+    DWORD got = 0;
+    BOOL ok = hRead && ReadFile(hRead, &out[old], static_cast<DWORD>(maxBytes), &got, nullptr);
+    channelCounters.syscall();
+    out.resize(old + (ok ? got : 0));
+    long n = ok ? static_cast<long>(got) : (GetLastError() == ERROR_BROKEN_PIPE ? 0 : -1);
+#else
+    ssize_t n = -1;
+    if (readFD != -1) {
+        do {
+            n = ::read(readFD, &out[old], maxBytes);
+            channelCounters.syscall();
+        } while (n < 0 && errno == EINTR);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) channelCounters.blocked();
+    }
+    out.resize(old + (n > 0 ? static_cast<size_t>(n) : 0));
+#endif
+    if (n > 0) channelCounters.read(static_cast<uint64_t>(n));
+    return static_cast<long>(n);
+}
+
+long Pipe::writeSome(std::string_view data) {
+#ifdef _WIN32
+    if (!hWrite) return -1;
+    DWORD written = 0;
+    if (!WriteFile(hWrite, data.data(), static_cast<DWORD>(data.size()), &written, nullptr))
+        return -1;
+    channelCounters.syscall();
+    channelCounters.wrote(written);
+    return static_cast<long>(written);
+#else
+    if (writeFD == -1) return -1;
+    ssize_t n;
+    do {
+        n = ::write(writeFD, data.data(), data.size());
+        channelCounters.syscall();
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) channelCounters.blocked();
+        return -1;
+    }
+    if (static_cast<size_t>(n) < data.size()) channelCounters.shortWrite();
+    channelCounters.wrote(static_cast<uint64_t>(n));
+    return static_cast<long>(n);
+#endif
+}
+
+bool Pipe::writeBytes(const void* data, size_t len) {
+    const char* p = static_cast<const char*>(data);
+    size_t left = len;
+#ifdef _WIN32
+    if (!hWrite) return false;
+    while (left > 0) {
+        DWORD written = 0;
+        DWORD chunk = static_cast<DWORD>(left > (1u << 30) ? (1u << 30) : left);
+        BOOL ok = WriteFile(hWrite, p, chunk, &written, nullptr);
+        channelCounters.syscall();
+        if (!ok || written == 0) break;
+        if (written < left) channelCounters.shortWrite();
+        left -= written;
+        p += written;
+    }
+#else
+    if (writeFD == -1) return false;
+    while (left > 0) {
+        ssize_t n = ::write(writeFD, p, left);
+        channelCounters.syscall();
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) channelCounters.blocked();
+        if (n <= 0) break;
+        if (static_cast<size_t>(n) < left) channelCounters.shortWrite();
+        left -= static_cast<size_t>(n);
+        p += n;
+    }
+#endif
+    channelCounters.wrote(len - left);
+    return left == 0;
+}
+
+bool Pipe::readExact(void* out, size_t len, size_t* received) {
+    if (received) *received = 0;
+    char* p = static_cast<char*>(out);
+    size_t left = len;
+#ifdef _WIN32
+    if (!hRead) return false;
+    while (left > 0) {
+        DWORD got = 0;
+        DWORD chunk = static_cast<DWORD>(left > (1u << 30) ? (1u << 30) : left);
+        BOOL ok = ReadFile(hRead, p, chunk, &got, nullptr);
+        channelCounters.syscall();
+        if (!ok || got == 0) break;
+        left -= got;
+        p += got;
+    }
+#else
+    if (readFD == -1) return false;
+    while (left > 0) {
+        ssize_t n = ::read(readFD, p, left);
+        channelCounters.syscall();
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) channelCounters.blocked();
+        if (n <= 0) break;
+        left -= static_cast<size_t>(n);
+        p += n;
+    }
+#endif
+    channelCounters.read(len - left);
+    if (received) *received = len - left;
+    return left == 0;
+}
+
+#ifdef _WIN32
+void Pipe::adopt(HANDLE read, HANDLE write) {
+    closeRead();
+    closeWrite();
+    hRead = read;
+    hWrite = write;
+}
+#else
+void Pipe::adopt(int read, int write) {
+    closeRead();
+    closeWrite();
+    readFD = read;
+    writeFD = write;
+}
+#endif
+
+#ifndef _WIN32
+void Pipe::setNonBlocking(bool on) {
+    for (int fd : { readFD, writeFD }) {
+        if (fd == -1) continue;
+        int flags = fcntl(fd, F_GETFL);
+        fcntl(fd, F_SETFL, on ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK));
+    }
+}
+#endif
+
+void Pipe::writeMany(std::span<const std::string_view> records) {
+#ifdef _WIN32
+    if (!hWrite) return;
+    std::string joined;
+    for (auto r : records) joined.append(r);
+    write(joined);
 #else
     if (writeFD == -1) return;
-    ::write(writeFD, data.c_str(), data.size());
+    size_t bytes = 0;
+    for (auto r : records) bytes += r.size();
+    if (bytes == 0) return;
+    PROCESS_TRACE2(pipe_write__entry, writeFD, bytes);
+    [[maybe_unused]] size_t total = write_records(writeFD, records, channelCounters);
+    PROCESS_TRACE2(pipe_write__return, writeFD, total);
 #endif
 }
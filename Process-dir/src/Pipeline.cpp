@@ -0,0 +1,90 @@
+// This is a demo version of PVS-Studio for educational use.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: https://pvs-studio.com
+#include "../include/Pipeline.h"
+#include <stdexcept>
+
+Pipeline& Pipeline::add(const std::string& path, const std::vector<std::string>& args,
+                        const SpawnOptions& options) {
+    stages.push_back(std::make_unique<Process>(path, args, options));
+    return *this;
+}
+
+bool Pipeline::start() {
+    if (stages.empty())
+        throw std::runtime_error("Pipeline has no stages");
+
+    links.clear();
+    for (size_t i = 0; i + 1 < stages.size(); i++) {
+        auto link = std::make_unique<Pipe>();
+        if (!link->create())
+            throw std::runtime_error("Pipeline pipe creation failed");
+#ifdef _WIN32
+        // startPiped() makes each end inheritable only for the stage using it.
+        SetHandleInformation(link->getReadHandle(), HANDLE_FLAG_INHERIT, 0);
+        SetHandleInformation(link->getWriteHandle(), HANDLE_FLAG_INHERIT, 0);
+#endif
+        links.push_back(std::move(link));
+    }
+
+    // The parent drops each end as soon as its stage owns it; otherwise a
+    // downstream stage would never see EOF.
+    size_t started = 0;
+    try {
+        for (; started < stages.size(); started++) {
+            size_t i = started;
+            Pipe* in  = i > 0 ? links[i - 1].get() : nullptr;
+            Pipe* out = i + 1 < stages.size() ? links[i].get() : nullptr;
+
+            stages[i]->startPiped(in, out);
+
+            if (in)  in->closeRead();
+            if (out) out->closeWrite();
+        }
+    } catch (...) {
+        // Stages already running would block on a link nobody serves.
+        for (size_t i = 0; i < started; i++) {
+            stages[i]->terminate();
+            stages[i]->wait();
+        }
+        links.clear();
+        throw;
+    }
+    return true;
+}
+
+void Pipeline::writeStdin(const std::string& input) {
+    stages.front()->writeStdin(input);
+}
+
+void Pipeline::closeStdin() {
+    stages.front()->closeStdin();
+}
+
+std::string Pipeline::readStdout() {
+    return stages.back()->readStdout();
+}
+
+std::string Pipeline::readStderr(size_t stage) {
+    return stages.at(stage)->readStderr();
+}
+
+std::vector<int> Pipeline::wait() {
+    std::vector<int> codes;
+    codes.reserve(stages.size());
+    for (auto& s : stages)
+        codes.push_back(s->wait());
+    return codes;
+}
+
+bool Pipeline::succeeded() const {
+    for (auto& s : stages) {
+        const ExitStatus& st = s->exitStatus();
+        if (!st.exited || st.code != 0) return false;
+    }
+    return !stages.empty();
+}
+
+void Pipeline::terminate() {
+    for (auto& s : stages)
+        s->terminate();
+}
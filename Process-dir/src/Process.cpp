@@ -1,29 +1,134 @@
 // This is a demo version of PVS-Studio for educational use.
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: https://pvs-studio.com
 #include "../include/Process.h"
+#include "../include/Tracing.h"
+#include "../include/SpawnServer.h"
+#include "../include/SigpipeGuard.h"
 #include <stdexcept>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
 
 #ifdef _WIN32
 #include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+
+// CreateProcessA takes "KEY=value\0KEY=value\0\0"; empty means inherit.
+static std::string environment_block(const SpawnOptions& o) {
+    std::string block;
+    if (!o.environment) return block;
+    for (auto& e : *o.environment) {
+        block += e;
+        block.push_back('\0');
+    }
+    block.push_back('\0');
+    return block;
+}
+
+Process::Process(const std::string& path, const std::vector<std::string>& args,
+                 const SpawnOptions& opts)
+    : executable(path), arguments(args), options(opts) {}
+
+Process::~Process() {
+    if (hProcess) CloseHandle(hProcess);
+    if (hThread) CloseHandle(hThread);
+    if (shmId)
+        SharedMemoryRegistry::instance().release(shmId);
+}
+
+void Process::onSpawned(int) {
+    status = ExitStatus{};
+    usage = ProcessStats{};
+    usage.startTime = std::chrono::system_clock::now();
+    spawnedAt = std::chrono::steady_clock::now();
+    reaped = false;
+
+    // Applied right after creation; NUMA placement is left to the OS here.
+    if (!options.cpus.empty()) {
+        DWORD_PTR mask = 0;
+        for (int cpu : options.cpus)
+            if (cpu >= 0 && cpu < static_cast<int>(8 * sizeof(DWORD_PTR)))
+                mask |= static_cast<DWORD_PTR>(1) << cpu;
+        if (mask) SetProcessAffinityMask(hProcess, mask);
+    }
+
+    labelChannels(GetProcessId(hProcess));
+}
+
+bool Process::reap(bool block) {
+    if (reaped) return true;
+    if (!hProcess) return false;
+
+    if (WaitForSingleObject(hProcess, block ? INFINITE : 0) != WAIT_OBJECT_0)
+        return false;
+
+    DWORD code = 0;
+    GetExitCodeProcess(hProcess, &code);
+    status.exited = true;
+    status.code = static_cast<int>(code);
+
+    usage.endTime = std::chrono::system_clock::now();
+    usage.wallTime = std::chrono::steady_clock::now() - spawnedAt;
+
+    FILETIME created, exited, kernel, user;
+    if (GetProcessTimes(hProcess, &created, &exited, &kernel, &user)) {
+        auto seconds = [](const FILETIME& ft) {
+            ULARGE_INTEGER v;
+            v.LowPart = ft.dwLowDateTime;
+            v.HighPart = ft.dwHighDateTime;
+            return static_cast<double>(v.QuadPart) / 1e7;   // 100 ns ticks
+        };
+        usage.userCpuSeconds = seconds(user);
+        usage.systemCpuSeconds = seconds(kernel);
+    }
+
+    PROCESS_MEMORY_COUNTERS mem{};
+    if (GetProcessMemoryInfo(hProcess, &mem, sizeof(mem))) {
+        usage.maxRssKb = static_cast<long>(mem.PeakWorkingSetSize / 1024);
+        usage.minorPageFaults = static_cast<long>(mem.PageFaultCount);
+    }
 
-Process::Process(const std::string& path, const std::vector<std::string>& args)
-    : executable(path), arguments(args) {}
+    CloseHandle(hProcess);
+    CloseHandle(hThread);
+    hProcess = nullptr;
+    hThread = nullptr;
+    reaped = true;
+    return true;
+}
 
 bool Process::start() {
+    return startPiped(nullptr, nullptr);
+}
+
+bool Process::startPiped(Pipe* stdinFrom, Pipe* stdoutTo) {
     useSockets = false;
     useSharedMemory = false;
 
-    if (!stdinPipe.create() || !stdoutPipe.create() || !stderrPipe.create())
+    if (!stderrPipe.create())
+        throw std::runtime_error("Pipe creation failed");
+    if (stdinFrom) {
+        stdinPipe.closeRead();
+        stdinPipe.closeWrite();
+    } else if (!stdinPipe.create()) {
+        throw std::runtime_error("Pipe creation failed");
+    }
+    if (stdoutTo) {
+        stdoutPipe.closeRead();
+        stdoutPipe.closeWrite();
+    } else if (!stdoutPipe.create()) {
         throw std::runtime_error("Pipe creation failed");
+    }
+
+    HANDLE childIn  = stdinFrom ? stdinFrom->getReadHandle() : stdinPipe.getReadHandle();
+    HANDLE childOut = stdoutTo ? stdoutTo->getWriteHandle() : stdoutPipe.getWriteHandle();
 
     // Ensure pipe handles are inherited
     SetHandleInformation(stdinPipe.getWriteHandle(), HANDLE_FLAG_INHERIT, 0); 
-    SetHandleInformation(stdinPipe.getReadHandle(), HANDLE_FLAG_INHERIT, 1);  
+    SetHandleInformation(childIn, HANDLE_FLAG_INHERIT, 1);  
 
     SetHandleInformation(stdoutPipe.getReadHandle(), HANDLE_FLAG_INHERIT, 0); 
-    SetHandleInformation(stdoutPipe.getWriteHandle(), HANDLE_FLAG_INHERIT, 1); 
+    SetHandleInformation(childOut, HANDLE_FLAG_INHERIT, 1); 
 
     SetHandleInformation(stderrPipe.getReadHandle(), HANDLE_FLAG_INHERIT, 0); 
     SetHandleInformation(stderrPipe.getWriteHandle(), HANDLE_FLAG_INHERIT, 1); 
@@ -33,8 +138,8 @@ bool Process::start() {
     si.cb = sizeof(STARTUPINFOA);
     si.dwFlags |= STARTF_USESTDHANDLES;
 
-    si.hStdInput  = stdinPipe.getReadHandle();
-    si.hStdOutput = stdoutPipe.getWriteHandle();
+    si.hStdInput  = childIn;
+    si.hStdOutput = childOut;
     si.hStdError  = stderrPipe.getWriteHandle();
 
     std::ostringstream cmd;
@@ -42,6 +147,7 @@ bool Process::start() {
     for (auto& a : arguments)
         cmd << " " << a;
 
+    std::string envBlock = environment_block(options);
     BOOL success = CreateProcessA(
         nullptr,
         const_cast<char*>(cmd.str().c_str()),
@@ -49,8 +155,8 @@ bool Process::start() {
         nullptr,
         TRUE, 
         0,
-        nullptr,
-        nullptr,
+        envBlock.empty() ? nullptr : envBlock.data(),
+        options.workingDirectory.empty() ? nullptr : options.workingDirectory.c_str(),
         &si,
         &pi
     );
@@ -58,12 +164,17 @@ bool Process::start() {
     if (!success)
         throw std::runtime_error("CreateProcessA failed");
 
-    CloseHandle(stdinPipe.getReadHandle());
-    CloseHandle(stdoutPipe.getWriteHandle());
-    CloseHandle(stderrPipe.getWriteHandle());
+    stdinPipe.closeRead();
+    stdoutPipe.closeWrite();
+    stderrPipe.closeWrite();
+
+    // Borrowed ends stay with the caller, but must not leak into later children.
+    if (stdinFrom) SetHandleInformation(childIn, HANDLE_FLAG_INHERIT, 0);
+    if (stdoutTo)  SetHandleInformation(childOut, HANDLE_FLAG_INHERIT, 0);
 
     hProcess = pi.hProcess;
     hThread  = pi.hThread;
+    onSpawned();
 
     return true;
 }
@@ -93,6 +204,7 @@ bool Process::startSockets(unsigned short basePort, SocketType type) {
     for (auto& a : arguments)
         cmd << " " << a;
 
+    std::string envBlock = environment_block(options);
     BOOL success = CreateProcessA(
         nullptr,
         const_cast<char*>(cmd.str().c_str()),
@@ -100,8 +212,8 @@ bool Process::startSockets(unsigned short basePort, SocketType type) {
         nullptr,
         FALSE,
         0,
-        nullptr,
-        nullptr,
+        envBlock.empty() ? nullptr : envBlock.data(),
+        options.workingDirectory.empty() ? nullptr : options.workingDirectory.c_str(),
         &si,
         &pi
     );
@@ -112,6 +224,7 @@ bool Process::startSockets(unsigned short basePort, SocketType type) {
 
     hProcess = pi.hProcess;
     hThread  = pi.hThread;
+    onSpawned();
 
     stdinClient  = stdinServer.acceptClient();
     std::cerr << "[parent] accepted stdin client\n";
@@ -123,17 +236,25 @@ bool Process::startSockets(unsigned short basePort, SocketType type) {
     return true;
 }
 
-bool Process::startSharedMemory(size_t size) {
+bool Process::startSharedMemory(size_t size, SharedMemoryMode mode) {
     useSharedMemory = true;
     useSockets = false;
     shmSize = size;
-
-    DWORD parentPid = GetCurrentProcessId();
-
-    std::string shmInName  = "/proc_shm_in_"  + std::to_string(parentPid);
-    std::string shmOutName = "/proc_shm_out_" + std::to_string(parentPid);
-    std::string semInName  = "/proc_sem_in_"  + std::to_string(parentPid);
-    std::string semOutName = "/proc_sem_out_" + std::to_string(parentPid);
+    // Named kernel objects on Windows are reference counted and vanish with
+    // their last handle, so Anonymous mode uses the named path here.
+    shmMode = mode;
+
+    SharedMemoryRegistry& registry = SharedMemoryRegistry::instance();
+    if (shmId)
+        registry.release(shmId);
+    shmId = registry.acquire();
+
+    std::string shmInName  = registry.name("shm_in",  shmId);
+    std::string shmOutName = registry.name("shm_out", shmId);
+    std::string semInName  = registry.name("sem_in",  shmId);
+    std::string semOutName = registry.name("sem_out", shmId);
+    std::string shmErrName = registry.name("shm_err", shmId);
+    std::string semErrName = registry.name("sem_err", shmId);
 
     if (!shmIn.create(shmInName, size))
         throw std::runtime_error("Failed to create shmIn");
@@ -141,13 +262,18 @@ bool Process::startSharedMemory(size_t size) {
     if (!shmOut.create(shmOutName, size))
         throw std::runtime_error("Failed to create shmOut");
 
+    if (!shmErr.create(shmErrName, size))
+        throw std::runtime_error("Failed to create shmErr");
+
     semIn.init(semInName, true, 0);
     semOut.init(semOutName, true, 0);
+    semErr.init(semErrName, true, 0);
 
     std::ostringstream cmd;
     cmd << "\"" << executable << "\"";
 
-    cmd << " " << shmInName << " " << shmOutName << " " << semInName << " " << semOutName;
+    cmd << " " << shmInName << " " << shmOutName << " " << semInName << " " << semOutName
+        << " " << shmErrName << " " << semErrName;
 
     for (auto& a : arguments)
         cmd << " " << a;
@@ -156,6 +282,7 @@ bool Process::startSharedMemory(size_t size) {
     PROCESS_INFORMATION pi{};
     si.cb = sizeof(STARTUPINFOA);
 
+    std::string envBlock = environment_block(options);
     BOOL success = CreateProcessA(
         nullptr,
         const_cast<char*>(cmd.str().c_str()),
@@ -163,8 +290,8 @@ bool Process::startSharedMemory(size_t size) {
         nullptr,
         FALSE,
         0,
-        nullptr,
-        nullptr,
+        envBlock.empty() ? nullptr : envBlock.data(),
+        options.workingDirectory.empty() ? nullptr : options.workingDirectory.c_str(),
         &si,
         &pi
     );
@@ -174,26 +301,55 @@ bool Process::startSharedMemory(size_t size) {
 
     hProcess = pi.hProcess;
     hThread  = pi.hThread;
+    onSpawned();
 
     return true;
 }
 
 int Process::wait() {
-    WaitForSingleObject(hProcess, INFINITE);
-    DWORD code = 0;
-    GetExitCodeProcess(hProcess, &code);
-    CloseHandle(hProcess);
-    CloseHandle(hThread);
-    hProcess = nullptr;
-    hThread = nullptr;
-    return static_cast<int>(code);
+    reap(true);
+    return status.code;
 }
 
-std::string Process::readStdout() {
-    if (useSharedMemory) {
-        semOut.wait();
-        return shmOut.read();
+bool Process::tryWait() {
+    return reap(false);
+}
+
+Process* Process::waitAny(std::span<Process* const> procs) {
+    for (;;) {
+        std::vector<HANDLE> handles;
+        std::vector<Process*> owners;
+        for (Process* p : procs) {
+            if (!p || p->reaped || !p->hProcess) continue;
+            handles.push_back(p->hProcess);
+            owners.push_back(p);
+        }
+        if (handles.empty()) return nullptr;
+
+        // WaitForMultipleObjects is limited to 64 handles; beyond that we
+        // sweep the set in chunks with a short timeout.
+        for (size_t first = 0; first < handles.size(); first += MAXIMUM_WAIT_OBJECTS) {
+            DWORD count = static_cast<DWORD>((std::min<size_t>)(MAXIMUM_WAIT_OBJECTS, handles.size() - first));
+            DWORD timeout = handles.size() <= MAXIMUM_WAIT_OBJECTS ? INFINITE : 10;
+            DWORD r = WaitForMultipleObjects(count, handles.data() + first, FALSE, timeout);
+            if (r < WAIT_OBJECT_0 + count) {
+                Process* p = owners[first + (r - WAIT_OBJECT_0)];
+                p->reap(false);
+                return p;
+            }
+        }
     }
+}
+
+Process* Process::waitAny(std::span<Process> procs) {
+    std::vector<Process*> ptrs;
+    for (auto& p : procs) ptrs.push_back(&p);
+    return waitAny(std::span<Process* const>(ptrs));
+}
+
+std::string Process::readStdout() {
+    if (useSharedMemory)
+        return readShared(shmOut, semOut);
     if (useSockets)
         return stdoutClient.readAll();
     return stdoutPipe.readAll();
@@ -201,7 +357,7 @@ std::string Process::readStdout() {
 
 std::string Process::readStderr() {
     if (useSharedMemory)
-        return ""; 
+        return readShared(shmErr, semErr);
     if (useSockets)
         return stderrClient.readAll();
     return stderrPipe.readAll();
@@ -220,7 +376,10 @@ void Process::writeStdin(const std::string& input) {
 }
 
 void Process::closeStdin() {
-    if (useSharedMemory) return; 
+    if (useSharedMemory) {
+        semIn.shutdown();
+        return;
+    }
 
     if (useSockets)
         stdinClient.close();
@@ -232,55 +391,328 @@ void Process::terminate() {
     if (hProcess) TerminateProcess(hProcess, 1);
 }
 
+// CreateProcess has no fork cost to amortise; this just starts them in turn.
+std::vector<std::unique_ptr<Process>> Process::spawnMany(size_t count, const Process& prototype) {
+    std::vector<std::unique_ptr<Process>> procs;
+    procs.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        procs.push_back(std::make_unique<Process>(prototype.executable, prototype.arguments, prototype.options));
+        procs.back()->start();
+    }
+    return procs;
+}
+
 // POSIX 
 #else
 
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <poll.h>
+#include <cstring>
 #include <csignal>
+#include <cerrno>
 
-Process::Process(const std::string& path, const std::vector<std::string>& args)
-    : executable(path), arguments(args) {}
+extern char** environ;
 
-bool Process::start() {
-    useSockets = false;
-    useSharedMemory = false;
+static void fill_stats(ProcessStats& st, const struct rusage& ru) {
+    st.userCpuSeconds   = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6;
+    st.systemCpuSeconds = ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+#ifdef __APPLE__
+    st.maxRssKb = ru.ru_maxrss / 1024;   // bytes on macOS
+#else
+    st.maxRssKb = ru.ru_maxrss;
+#endif
+    st.voluntaryContextSwitches   = ru.ru_nvcsw;
+    st.involuntaryContextSwitches = ru.ru_nivcsw;
+    st.minorPageFaults = ru.ru_minflt;
+    st.majorPageFaults = ru.ru_majflt;
+}
 
-    if (!stdinPipe.create() || !stdoutPipe.create() || !stderrPipe.create())
-        throw std::runtime_error("Pipe creation failed");
+static ExitStatus decode_status(int raw) {
+    ExitStatus st;
+    if (WIFEXITED(raw)) {
+        st.exited = true;
+        st.code = WEXITSTATUS(raw);
+    } else if (WIFSIGNALED(raw)) {
+        st.signal = WTERMSIG(raw);
+#ifdef WCOREDUMP
+        st.coreDumped = WCOREDUMP(raw);
+#endif
+    }
+    return st;
+}
+
+Process::Process(const std::string& path, const std::vector<std::string>& args,
+                 const SpawnOptions& opts)
+    : executable(path), arguments(args), options(opts),
+      arena(std::make_shared<const SpawnArena>(path, args, opts)) {}
+
+Process::~Process() {
+    if (pidFD != -1) ::close(pidFD);
+    if (shmId)
+        SharedMemoryRegistry::instance().release(shmId);
+}
+
+// Async-signal-safe error path for the forked child.
+[[noreturn]] static void child_fail(const char* what, const char* detail) {
+    ssize_t ignored = ::write(STDERR_FILENO, what, std::strlen(what));
+    ignored = ::write(STDERR_FILENO, detail, std::strlen(detail));
+    ignored = ::write(STDERR_FILENO, "\n", 1);
+    (void)ignored;
+    _exit(127);
+}
+
+// Runs in the forked child and never returns. Everything it touches was
+// prepared by the parent (and the arena at construction), so it only makes
+// raw syscalls: no allocation, no locks, safe in a multithreaded parent and
+// in a vfork() child, which borrows the parent's memory until execve.
+void Process::execChild(const sigset_t* restoreMask) const {
+    int from[maxRedirects];
+    size_t n = redirects.size();   // <= maxRedirects, checked by the parent
+
+    // A source sitting on a stdio number could be clobbered by an earlier
+    // dup2, so move it out of the way first.
+    for (size_t i = 0; i < n; i++) {
+        from[i] = redirects[i].from;
+        if (from[i] <= STDERR_FILENO && from[i] != redirects[i].to)
+            from[i] = fcntl(from[i], F_DUPFD_CLOEXEC, STDERR_FILENO + 1);
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (from[i] == redirects[i].to)
+            fcntl(from[i], F_SETFD, 0);   // dup2 would leave FD_CLOEXEC set
+        else
+            dup2(from[i], redirects[i].to);
+    }
+
+    arena->applyPlacement();
+    arena->closeFdsExcept(keepFds.data(), keepFds.size());
+
+    if (const char* cwd = arena->workingDirectory())
+        if (chdir(cwd) != 0)
+            child_fail("chdir failed: ", cwd);
+
+    char* const* envp = arena->envp();
+    if (restoreMask)
+        sigprocmask(SIG_SETMASK, restoreMask, nullptr);
+    execve(arena->path(), argvTable.data(), envp ? envp : environ);
+    child_fail("execve failed: ", arena->path());
+}
+
+// Builds the argv table for this spawn, forks and execs (or hands both to
+// the spawn server). Callers fill transportArgs, redirects and keepFds first.
+void Process::spawn() {
+    if (redirects.size() > maxRedirects)
+        throw std::runtime_error("Too many redirects for one spawn");
+    arena->buildArgv(transportArgs, argvTable);
+    std::sort(keepFds.begin(), keepFds.end());
+
+    if (options.spawnServer) {
+        std::vector<int> fds, targets;
+        for (const Redirect& r : redirects) {
+            fds.push_back(r.from);
+            targets.push_back(r.to);
+        }
+        for (int fd : keepFds) {
+            fds.push_back(fd);
+            targets.push_back(fd);
+        }
+        int serverPidFD = -1;
+        pid = options.spawnServer->spawn(arena->path(), argvTable.data(), options,
+                                         fds.data(), targets.data(), fds.size(), serverPidFD);
+        onSpawned(serverPidFD);
+        return;
+    }
+
+    // SIGPIPE blocked by a SigpipeGuard is the parent's business; the
+    // child gets the mask it would have had without the guard.
+    sigset_t childMask;
+    const sigset_t* restoreMask = nullptr;
+    if (SigpipeGuard::active()) {
+        pthread_sigmask(SIG_SETMASK, nullptr, &childMask);
+        sigdelset(&childMask, SIGPIPE);
+        restoreMask = &childMask;
+    }
 
     pid = fork();
     if (pid < 0) throw std::runtime_error("fork failed");
+    if (pid == 0) execChild(restoreMask);
 
-    if (pid == 0) {
-        dup2(stdoutPipe.getWriteFD(), STDOUT_FILENO);
-        dup2(stderrPipe.getWriteFD(), STDERR_FILENO);
-        dup2(stdinPipe.getReadFD(), STDIN_FILENO);
+    onSpawned();
+}
 
-        stdoutPipe.closeRead();
-        stderrPipe.closeRead();
-        stdinPipe.closeWrite();
+void Process::onSpawned(int givenPidFD) {
+    status = ExitStatus{};
+    usage = ProcessStats{};
+    usage.startTime = std::chrono::system_clock::now();
+    spawnedAt = std::chrono::steady_clock::now();
+    reaped = false;
+
+    if (pidFD != -1) ::close(pidFD);
+    pidFD = givenPidFD;
+#ifdef SYS_pidfd_open
+    if (pidFD == -1)
+        pidFD = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#endif
+
+    labelChannels(static_cast<unsigned long>(pid));
+}
 
-        std::vector<char*> argv;
-        argv.push_back(const_cast<char*>(executable.c_str()));
-        for (auto& a : arguments)
-            argv.push_back(const_cast<char*>(a.c_str()));
-        argv.push_back(nullptr);
+bool Process::reap(bool block) {
+    if (reaped) return true;
+    if (pid <= 0) return false;
+
+    int raw = 0;
+    struct rusage ru{};
+    pid_t r;
+    if (options.spawnServer) {
+        r = options.spawnServer->wait(pid, pidFD, block, raw, ru);
+    } else {
+        do {
+            r = wait4(pid, &raw, block ? 0 : WNOHANG, &ru);
+        } while (r == -1 && errno == EINTR);
+    }
 
-        if (execvp(executable.c_str(), argv.data()) == -1) {
-            perror("execvp failed");
-            _exit(127);
-        }
+    if (r == 0) return false;
+    if (r == pid) {
+        status = decode_status(raw);
+        fill_stats(usage, ru);
     }
+    usage.endTime = std::chrono::system_clock::now();
+    usage.wallTime = std::chrono::steady_clock::now() - spawnedAt;
+
+    // r == -1: somebody else already reaped it; report what we know.
+    reaped = true;
+    if (pidFD != -1) {
+        ::close(pidFD);
+        pidFD = -1;
+    }
+    return true;
+}
+
+bool Process::start() {
+    return startPiped(nullptr, nullptr);
+}
+
+bool Process::startPiped(Pipe* stdinFrom, Pipe* stdoutTo) {
+    PROCESS_TRACE1(start__entry, static_cast<unsigned>(Transport::Pipe));
+    preparePipes(stdinFrom, stdoutTo);
+    spawn();
+    closeChildEnds();
+    PROCESS_TRACE2(start__return, pid, static_cast<unsigned>(Transport::Pipe));
+    return true;
+}
 
+// Creates this spawn's pipes and fills the redirect plan for execChild().
+void Process::preparePipes(Pipe* stdinFrom, Pipe* stdoutTo) {
+    useSockets = false;
+    useSharedMemory = false;
+
+    if (!stderrPipe.create())
+        throw std::runtime_error("Pipe creation failed");
+    if (stdinFrom) {
+        stdinPipe.closeRead();
+        stdinPipe.closeWrite();
+    } else if (!stdinPipe.create()) {
+        throw std::runtime_error("Pipe creation failed");
+    }
+    if (stdoutTo) {
+        stdoutPipe.closeRead();
+        stdoutPipe.closeWrite();
+    } else if (!stdoutPipe.create()) {
+        throw std::runtime_error("Pipe creation failed");
+    }
+
+    transportArgs.clear();
+    redirects.clear();
+    redirects.push_back({ stdoutTo ? stdoutTo->getWriteFD() : stdoutPipe.getWriteFD(), STDOUT_FILENO });
+    redirects.push_back({ stderrPipe.getWriteFD(), STDERR_FILENO });
+    redirects.push_back({ stdinFrom ? stdinFrom->getReadFD() : stdinPipe.getReadFD(), STDIN_FILENO });
+    keepFds.clear();
+}
+
+// The child holds its own copies now.
+void Process::closeChildEnds() {
     stdoutPipe.closeWrite();
     stderrPipe.closeWrite();
     stdinPipe.closeRead();
+}
 
-    return true;
+Process::Process(const Process& prototype, std::shared_ptr<const SpawnArena> sharedArena)
+    : executable(prototype.executable), arguments(prototype.arguments), options(prototype.options),
+      arena(std::move(sharedArena)) {}
+
+pid_t Process::vforkChild(const sigset_t* restoreMask) const {
+    pid_t child = vfork();
+    if (child == 0) execChild(restoreMask);
+    return child;
+}
+
+std::vector<std::unique_ptr<Process>> Process::spawnMany(size_t count, const Process& prototype) {
+    std::vector<std::unique_ptr<Process>> procs;
+    procs.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        procs.emplace_back(new Process(prototype, prototype.arena));
+        procs.back()->preparePipes(nullptr, nullptr);
+        if (procs.back()->redirects.size() > maxRedirects)
+            throw std::runtime_error("Too many redirects for one spawn");
+        procs.back()->arena->buildArgv(procs.back()->transportArgs, procs.back()->argvTable);
+    }
+
+    // The server already forks from a small image; go through it as usual.
+    if (prototype.options.spawnServer) {
+        size_t started = 0;
+        try {
+            for (; started < count; started++) {
+                procs[started]->spawn();
+                procs[started]->closeChildEnds();
+            }
+        } catch (...) {
+            for (size_t i = 0; i < started; i++) {
+                procs[i]->terminate();
+                procs[i]->wait();
+            }
+            throw;
+        }
+        return procs;
+    }
+
+    // vfork() shares the parent's memory until execve, so no signal
+    // handler may run in the child on the parent's behalf; the child
+    // restores the mask right before exec.
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    sigset_t childMask = old;
+    if (SigpipeGuard::active())
+        sigdelset(&childMask, SIGPIPE);
+
+    size_t started = 0;
+    for (; started < count; started++) {
+        Process& p = *procs[started];
+        PROCESS_TRACE1(start__entry, static_cast<unsigned>(Transport::Pipe));
+        p.pid = p.vforkChild(&childMask);
+        if (p.pid < 0) break;
+        p.onSpawned();
+        p.closeChildEnds();
+        PROCESS_TRACE2(start__return, p.pid, static_cast<unsigned>(Transport::Pipe));
+    }
+    pthread_sigmask(SIG_SETMASK, &old, nullptr);
+
+    if (started < count) {
+        for (size_t i = 0; i < started; i++) {
+            procs[i]->terminate();
+            procs[i]->wait();
+        }
+        throw std::runtime_error("vfork failed");
+    }
+    return procs;
 }
 
 bool Process::startSockets(unsigned short basePort, SocketType type) {
+    PROCESS_TRACE1(start__entry, static_cast<unsigned>(Transport::Socket));
     useSockets = true;
     useSharedMemory = false;
 
@@ -292,34 +724,15 @@ bool Process::startSockets(unsigned short basePort, SocketType type) {
         !stderrServer.bindAndListen(basePort + 2))
         throw std::runtime_error("bind/listen failed");
 
-    pid = fork();
-    if (pid < 0) throw std::runtime_error("fork failed");
+    transportArgs.clear();
+    transportArgs.push_back(type == SocketType::Unix ? "unix" : "ipv4");
+    transportArgs.push_back(std::to_string(basePort));
+    transportArgs.push_back(std::to_string(basePort + 1));
+    transportArgs.push_back(std::to_string(basePort + 2));
+    redirects.clear();
+    keepFds.clear();
 
-    if (pid == 0) {
-        std::string domain = (type == SocketType::Unix) ? "unix" : "ipv4";
-        std::string p0 = std::to_string(basePort);
-        std::string p1 = std::to_string(basePort + 1);
-        std::string p2 = std::to_string(basePort + 2);
-
-        std::vector<std::string> allArgs;
-        allArgs.push_back(domain);
-        allArgs.push_back(p0);
-        allArgs.push_back(p1);
-        allArgs.push_back(p2);
-        allArgs.insert(allArgs.end(), arguments.begin(), arguments.end());
-
-        std::vector<char*> argv;
-        argv.push_back(const_cast<char*>(executable.c_str()));
-        for (auto& a : allArgs)
-            argv.push_back(const_cast<char*>(a.data()));
-        argv.push_back(nullptr);
-
-        if (pid == 0) {
-            execvp(executable.c_str(), argv.data());
-            perror("execvp failed");
-            _exit(127);
-        }
-    }
+    spawn();
 
     stdinClient  = stdinServer.acceptClient();
     std::cerr << "[parent] accepted stdin client\n";
@@ -328,63 +741,144 @@ bool Process::startSockets(unsigned short basePort, SocketType type) {
     stderrClient = stderrServer.acceptClient();
     std::cerr << "[parent] accepted stderr client\n";
 
-
+    PROCESS_TRACE2(start__return, pid, static_cast<unsigned>(Transport::Socket));
     return true;
 }
 
-bool Process::startSharedMemory(size_t size) {
+bool Process::startSharedMemory(size_t size, SharedMemoryMode mode) {
+    PROCESS_TRACE1(start__entry, static_cast<unsigned>(Transport::SharedMemory));
     useSharedMemory = true;
+    useSockets = false;
     shmSize = size;
+    shmMode = mode;
+
+    std::string shmInName, shmOutName, semInName, semOutName, shmErrName, semErrName;
+
+    if (mode == SharedMemoryMode::Anonymous) {
+        if (!shmIn.createAnonymous(size))
+            throw std::runtime_error("Failed to create anonymous shmIn");
+
+        if (!shmOut.createAnonymous(size))
+            throw std::runtime_error("Failed to create anonymous shmOut");
+
+        if (!shmErr.createAnonymous(size))
+            throw std::runtime_error("Failed to create anonymous shmErr");
+
+        semIn.initAnonymous(0);
+        semOut.initAnonymous(0);
+        semErr.initAnonymous(0);
+
+        shmInName  = "fd:" + std::to_string(shmIn.getFD());
+        shmOutName = "fd:" + std::to_string(shmOut.getFD());
+        semInName  = "fd:" + std::to_string(semIn.getFD());
+        semOutName = "fd:" + std::to_string(semOut.getFD());
+        shmErrName = "fd:" + std::to_string(shmErr.getFD());
+        semErrName = "fd:" + std::to_string(semErr.getFD());
+    } else {
+        SharedMemoryRegistry& registry = SharedMemoryRegistry::instance();
+        if (shmId)
+            registry.release(shmId);
+        shmId = registry.acquire();
+
+        shmInName  = registry.name("shm_in",  shmId);
+        shmOutName = registry.name("shm_out", shmId);
+        semInName  = registry.name("sem_in",  shmId);
+        semOutName = registry.name("sem_out", shmId);
+        shmErrName = registry.name("shm_err", shmId);
+        semErrName = registry.name("sem_err", shmId);
+
+        if (!shmIn.create(shmInName, size))
+            throw std::runtime_error("Failed to create shmIn");
+
+        if (!shmOut.create(shmOutName, size))
+            throw std::runtime_error("Failed to create shmOut");
+
+        if (!shmErr.create(shmErrName, size))
+            throw std::runtime_error("Failed to create shmErr");
+
+        // Create semaphores (parent only)
+        semIn.init(semInName, true, 0);
+        semOut.init(semOutName, true, 0);
+        semErr.init(semErrName, true, 0);
+    }
 
-    int parentPid = getpid();
-
-    std::string shmInName  = "/proc_shm_in_"  + std::to_string(parentPid);
-    std::string shmOutName = "/proc_shm_out_" + std::to_string(parentPid);
-    std::string semInName  = "/proc_sem_in_"  + std::to_string(parentPid);
-    std::string semOutName = "/proc_sem_out_" + std::to_string(parentPid);
-
-    if (!shmIn.create(shmInName, size))
-        throw std::runtime_error("Failed to create shmIn");
-
-    if (!shmOut.create(shmOutName, size))
-        throw std::runtime_error("Failed to create shmOut");
-
-    // Create semaphores (parent only)
-    semIn.init(semInName, true, 0);
-    semOut.init(semOutName, true, 0);
-
-    pid = fork();
-    if (pid < 0)
-        throw std::runtime_error("fork failed");
-
-    if (pid == 0) {
+    if (options.numaNode >= 0) {
+        shmIn.bindToNumaNode(options.numaNode);
+        shmOut.bindToNumaNode(options.numaNode);
+        shmErr.bindToNumaNode(options.numaNode);
+    }
 
-        std::vector<char*> argv;
+    // The err pair goes last so children written for the original four
+    // arguments keep working.
+    transportArgs.clear();
+    transportArgs.push_back(shmInName);
+    transportArgs.push_back(shmOutName);
+    transportArgs.push_back(semInName);
+    transportArgs.push_back(semOutName);
+    transportArgs.push_back(shmErrName);
+    transportArgs.push_back(semErrName);
+    redirects.clear();
+    keepFds.clear();
+
+    // Anonymous segments reach the child only through these descriptors.
+    if (mode == SharedMemoryMode::Anonymous)
+        keepFds = { shmIn.getFD(), shmOut.getFD(), semIn.getFD(), semOut.getFD(),
+                    shmErr.getFD(), semErr.getFD() };
+
+    spawn();
+
+    PROCESS_TRACE2(start__return, pid, static_cast<unsigned>(Transport::SharedMemory));
+    return true;
+}
 
-        argv.push_back(const_cast<char*>(executable.c_str()));
+int Process::wait() {
+    PROCESS_TRACE1(wait__entry, pid);
+    reap(true);
+    PROCESS_TRACE2(wait__return, pid, status.exited ? status.code : -status.signal);
+    return status.exited ? status.code : -1;
+}
 
-        argv.push_back(const_cast<char*>(shmInName.c_str()));
-        argv.push_back(const_cast<char*>(shmOutName.c_str()));
-        argv.push_back(const_cast<char*>(semInName.c_str()));
-        argv.push_back(const_cast<char*>(semOutName.c_str()));
+bool Process::tryWait() {
+    return reap(false);
+}
 
-        for (auto &a : arguments)
-            argv.push_back(const_cast<char*>(a.c_str()));
+Process* Process::waitAny(std::span<Process* const> procs) {
+    std::vector<pollfd> fds;
+    std::vector<Process*> owners;
+
+    for (;;) {
+        fds.clear();
+        owners.clear();
+        bool needsPolling = false;
+
+        for (Process* p : procs) {
+            if (!p || p->reaped || p->pid <= 0) continue;
+            if (p->tryWait()) return p;
+            if (p->pidFD == -1) {
+                needsPolling = true;
+                continue;
+            }
+            fds.push_back({ p->pidFD, POLLIN, 0 });
+            owners.push_back(p);
+        }
+        if (fds.empty() && !needsPolling) return nullptr;
 
-        argv.push_back(nullptr);
+        // Children without a pidfd (old kernels) are rechecked every 10 ms.
+        int r = ::poll(fds.data(), fds.size(), needsPolling ? 10 : -1);
+        if (r < 0 && errno != EINTR) return nullptr;
 
-        execvp(executable.c_str(), argv.data());
-        perror("execvp failed");
-        _exit(127);
+        for (size_t i = 0; r > 0 && i < fds.size(); i++) {
+            if (fds[i].revents && owners[i]->tryWait())
+                return owners[i];
+        }
     }
-
-    return true;
 }
 
-int Process::wait() {
-    int status = 0;
-    waitpid(pid, &status, 0);
-    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+Process* Process::waitAny(std::span<Process> procs) {
+    std::vector<Process*> ptrs;
+    ptrs.reserve(procs.size());
+    for (auto& p : procs) ptrs.push_back(&p);
+    return waitAny(std::span<Process* const>(ptrs));
 }
 
 void Process::writeStdin(const std::string& s) {
@@ -401,10 +895,8 @@ void Process::writeStdin(const std::string& s) {
 }
 
 std::string Process::readStdout() {
-    if (useSharedMemory) {
-        semOut.wait();
-        return shmOut.read();
-    }
+    if (useSharedMemory)
+        return readShared(shmOut, semOut);
 
     if (useSockets)
         return stdoutClient.readAll();
@@ -414,7 +906,7 @@ std::string Process::readStdout() {
 
 std::string Process::readStderr() {
     if (useSharedMemory)
-        return "";
+        return readShared(shmErr, semErr);
 
     if (useSockets)
         return stderrClient.readAll();
@@ -423,8 +915,10 @@ std::string Process::readStderr() {
 }
 
 void Process::closeStdin() {
-    if (useSharedMemory)
+    if (useSharedMemory) {
+        semIn.shutdown();
         return;
+    }
 
     if (useSockets)
         stdinClient.close();
@@ -436,4 +930,146 @@ void Process::terminate() {
     if (pid > 0) kill(pid, SIGKILL);
 }
 
-#endif
\ No newline at end of file
+#endif
+
+// A child that dies without shutting its streams down must not leave the
+// reader blocked, so the wait is sliced and the child is polled in between.
+std::string Process::readShared(SharedMemoryChannel& shm, SharedSemaphore& sem) {
+    for (;;) {
+        if (sem.waitFor(50))
+            return shm.read();
+        if (sem.isShutdown())
+            return "";
+        if (tryWait())
+            return sem.waitFor(0) ? shm.read() : "";
+    }
+}
+
+void Process::writeStdinMany(std::span<const std::string_view> records) {
+    if (useSharedMemory) {
+        size_t total = 0;
+        for (auto r : records) total += r.size();
+        if (total >= shmIn.getSize())
+            throw std::runtime_error("Batch of " + std::to_string(total) +
+                                     " bytes does not fit the shared-memory stdin segment");
+        std::string joined;
+        joined.reserve(total);
+        for (auto r : records) joined.append(r);
+        shmIn.write(joined);
+        semIn.post();
+        return;
+    }
+
+    if (useSockets)
+        stdinClient.writeMany(records);
+    else
+        stdinPipe.writeMany(records);
+}
+
+void Process::beginBatch() {
+    stdinBatch.clear();
+}
+
+void Process::appendStdin(std::string_view record) {
+    stdinBatch.append(record);
+}
+
+void Process::flushStdin() {
+    if (stdinBatch.empty()) return;
+    std::string_view all(stdinBatch);
+    writeStdinMany(std::span<const std::string_view>(&all, 1));
+    stdinBatch.clear();
+}
+
+const char* to_string(Transport t) {
+    switch (t) {
+    case Transport::Pipe:         return "pipe";
+    case Transport::Socket:       return "socket";
+    case Transport::SharedMemory: return "shared-memory";
+    }
+    return "unknown";
+}
+
+Transport Process::transport() const {
+    if (useSharedMemory) return Transport::SharedMemory;
+    if (useSockets)      return Transport::Socket;
+    return Transport::Pipe;
+}
+
+// Beyond a pipe buffer's worth per message (or that much per second of
+// sustained traffic) the copy through the kernel dominates, and a mapped
+// segment the child reads in place wins. Sockets only pay off when the
+// peer may be remote.
+bool Process::startAuto(const TransportHints& hints) {
+    constexpr size_t pipeBuffer = 64 * 1024;
+    constexpr double bulkBytesPerSecond = 64.0 * 1024 * 1024;
+
+    auto supports = [&](Transport t) { return (hints.supported & static_cast<unsigned>(t)) != 0; };
+
+    if (hints.remote) {
+        if (!supports(Transport::Socket))
+            throw std::runtime_error("startAuto: remote peer requires a socket transport");
+        return startSockets(hints.basePort, hints.socketType);
+    }
+
+    bool bulk = hints.messageSize >= pipeBuffer ||
+                hints.messageSize * hints.messagesPerSecond >= bulkBytesPerSecond;
+
+    if (supports(Transport::SharedMemory) && (bulk || !supports(Transport::Pipe))) {
+        // One message occupies the segment, plus its terminating NUL.
+        const size_t page = 4096;
+        size_t size = (std::max)(page, (hints.messageSize + 1 + page - 1) / page * page);
+        return startSharedMemory(size);
+    }
+    if (supports(Transport::Pipe))
+        return start();
+    if (supports(Transport::Socket))
+        return startSockets(hints.basePort, hints.socketType);
+
+    throw std::runtime_error("startAuto: no supported transport");
+}
+
+// Names the active transport's channels after the child, so a metrics
+// snapshot shows which child a slow channel belongs to.
+void Process::labelChannels(unsigned long childPid) {
+    std::string base = executable + "[" + std::to_string(childPid) + "] ";
+
+    if (useSharedMemory) {
+        shmIn.counters().setLabel(base + "stdin");
+        shmOut.counters().setLabel(base + "stdout");
+        shmErr.counters().setLabel(base + "stderr");
+        semIn.counters().setLabel(base + "stdin");
+        semOut.counters().setLabel(base + "stdout");
+        semErr.counters().setLabel(base + "stderr");
+    } else if (useSockets) {
+        stdinClient.counters().setLabel(base + "stdin");
+        stdoutClient.counters().setLabel(base + "stdout");
+        stderrClient.counters().setLabel(base + "stderr");
+    } else {
+        stdinPipe.counters().setLabel(base + "stdin");
+        stdoutPipe.counters().setLabel(base + "stdout");
+        stderrPipe.counters().setLabel(base + "stderr");
+    }
+}
+
+std::uint64_t Process::readStdoutTo(OutputSpool& spool) {
+    if (useSharedMemory) {
+        std::string msg = readShared(shmOut, semOut);
+        spool.append(msg);
+        return msg.size();
+    }
+    if (useSockets)
+        return stdoutClient.readAllTo(spool);
+    return stdoutPipe.readAllTo(spool);
+}
+
+std::uint64_t Process::readStderrTo(OutputSpool& spool) {
+    if (useSharedMemory) {
+        std::string msg = readShared(shmErr, semErr);
+        spool.append(msg);
+        return msg.size();
+    }
+    if (useSockets)
+        return stderrClient.readAllTo(spool);
+    return stderrPipe.readAllTo(spool);
+}
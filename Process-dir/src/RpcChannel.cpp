@@ -0,0 +1,247 @@
+// This is a demo version of PVS-Studio for educational use.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: https://pvs-studio.com
+#include "../include/RpcChannel.h"
+#include "../include/Process.h"
+#include <stdexcept>
+#include <cstring>
+#include <vector>
+#include <chrono>
+
+namespace {
+
+constexpr size_t headerSize = sizeof(std::uint32_t) + sizeof(std::uint64_t);
+
+}
+
+bool RpcLink::queuePeerGone() const {
+    return queueOut->isShutdown() || queueIn->isShutdown() || (alive && !alive());
+}
+
+bool RpcLink::send(std::uint64_t id, std::string_view payload, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    std::unique_lock<std::timed_mutex> guard(sending, std::defer_lock);
+    if (timeoutMs < 0)
+        guard.lock();
+    else if (!guard.try_lock_until(deadline))
+        return false;
+
+    if (queueOut) {
+        if (sizeof(id) + payload.size() > queueOut->slotSize())
+            throw std::runtime_error("RpcLink: message exceeds queue slot size");
+        std::vector<char> msg(sizeof(id) + payload.size());
+        std::memcpy(msg.data(), &id, sizeof(id));
+        if (!payload.empty())
+            std::memcpy(msg.data() + sizeof(id), payload.data(), payload.size());
+        // A full queue with nobody draining it would spin forever in push().
+        for (unsigned spin = 0; !queueOut->tryPush(msg.data(), msg.size()); spin++) {
+            if (queuePeerGone()) return false;
+            if (timeoutMs >= 0 && std::chrono::steady_clock::now() >= deadline) return false;
+            if (spin < 64)
+                std::this_thread::yield();
+            else
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    if (payload.size() > maxFrame)
+        throw std::runtime_error("RpcLink: message exceeds maximum frame size");
+    // Header and payload go out in one write.
+    std::uint32_t len = static_cast<std::uint32_t>(payload.size());
+    std::vector<char> frame(headerSize + payload.size());
+    std::memcpy(frame.data(), &len, sizeof(len));
+    std::memcpy(frame.data() + sizeof(len), &id, sizeof(id));
+    if (!payload.empty())
+        std::memcpy(frame.data() + headerSize, payload.data(), payload.size());
+    return socket ? socket->writeBytes(frame.data(), frame.size())
+                  : out->writeBytes(frame.data(), frame.size());
+}
+
+bool RpcLink::receive(std::uint64_t& id, std::string& payload) {
+    if (queueIn) {
+        std::string msg(queueIn->slotSize(), '\0');
+        size_t len = 0;
+        while (!queueIn->pop(msg.data(), msg.size(), len, peerPollMs)) {
+            if (queueIn->isShutdown() || (alive && !alive()))
+                return false;
+        }
+        if (len < sizeof(id)) return false;
+        std::memcpy(&id, msg.data(), sizeof(id));
+        payload.assign(msg, sizeof(id), len - sizeof(id));
+        return true;
+    }
+
+    auto readExact = [this](void* buf, size_t len) {
+        return socket ? socket->readExact(buf, len) : in->readExact(buf, len);
+    };
+    char header[headerSize];
+    if (!readExact(header, sizeof(header))) return false;
+    std::uint32_t len;
+    std::memcpy(&len, header, sizeof(len));
+    std::memcpy(&id, header + sizeof(len), sizeof(id));
+    if (len > maxFrame) return false;
+    payload.resize(len);
+    return len == 0 || readExact(payload.data(), len);
+}
+
+void RpcLink::interrupt() {
+    if (queueIn) queueIn->shutdown();
+}
+
+RpcChannel::RpcChannel(Process& child, size_t maxInFlight)
+    : RpcChannel(child.stdinStream(), child.stdoutStream(), maxInFlight) {}
+
+RpcChannel::RpcChannel(Pipe& requests, Pipe& responses, size_t maxInFlight)
+    : link(requests, responses), limit(maxInFlight ? maxInFlight : 1) {
+    reader = std::thread(&RpcChannel::readLoop, this);
+}
+
+RpcChannel::RpcChannel(SocketChannel& socket, size_t maxInFlight)
+    : link(socket), limit(maxInFlight ? maxInFlight : 1) {
+    reader = std::thread(&RpcChannel::readLoop, this);
+}
+
+RpcChannel::RpcChannel(SharedWorkQueue& requests, SharedWorkQueue& responses, size_t maxInFlight,
+                       std::function<bool()> peerAlive)
+    : link(requests, responses, std::move(peerAlive)), limit(maxInFlight ? maxInFlight : 1) {
+    reader = std::thread(&RpcChannel::readLoop, this);
+}
+
+RpcChannel::~RpcChannel() {
+    close();
+}
+
+size_t RpcChannel::inFlight() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return pending.size();
+}
+
+// Size is checked here, before the entry takes a slot, because a send()
+// that throws would leave the entry registered for good.
+std::uint64_t RpcChannel::enqueue(Pending entry, size_t requestSize) {
+    if (requestSize > link.maxPayload())
+        throw std::runtime_error("RpcChannel: request exceeds the link's maximum payload");
+    std::unique_lock<std::mutex> guard(lock);
+    slotFree.wait(guard, [this] { return pending.size() < limit || closing || finished; });
+    if (closing || finished)
+        throw std::runtime_error("RpcChannel is closed");
+    std::uint64_t id = nextId++;
+    pending.emplace(id, std::move(entry));
+    return id;
+}
+
+// The entry is registered before the request is written, so a fast reply
+// always finds it.
+void RpcChannel::submit(std::uint64_t id, std::string_view request) {
+    int timeoutMs = link.interruptible() ? static_cast<int>(queueSendTimeout.count()) : -1;
+    if (link.send(id, request, timeoutMs)) return;
+
+    std::unique_lock<std::mutex> guard(lock);
+    auto it = pending.find(id);
+    if (it == pending.end()) return;      // the reader already failed it
+    Pending p = std::move(it->second);
+    pending.erase(it);
+    guard.unlock();
+    slotFree.notify_one();
+    complete(p, false, {});
+}
+
+std::future<std::string> RpcChannel::call(std::string_view request) {
+    Pending entry;
+    std::future<std::string> result = entry.promise.get_future();
+    submit(enqueue(std::move(entry), request.size()), request);
+    return result;
+}
+
+void RpcChannel::call(std::string_view request, Callback callback) {
+    Pending entry;
+    entry.callback = std::move(callback);
+    submit(enqueue(std::move(entry), request.size()), request);
+}
+
+void RpcChannel::complete(Pending& p, bool ok, std::string reply) {
+    if (p.callback) {
+        p.callback(ok, std::move(reply));
+    } else if (ok) {
+        p.promise.set_value(std::move(reply));
+    } else {
+        p.promise.set_exception(std::make_exception_ptr(
+            std::runtime_error("RpcChannel: peer closed before replying")));
+    }
+}
+
+void RpcChannel::readLoop() {
+    std::uint64_t id;
+    std::string reply;
+    while (link.receive(id, reply)) {
+        if (id == 0) break;                // server acknowledged close
+        std::unique_lock<std::mutex> guard(lock);
+        auto it = pending.find(id);
+        if (it == pending.end()) continue; // not ours; drop it
+        Pending p = std::move(it->second);
+        pending.erase(it);
+        guard.unlock();
+        slotFree.notify_one();
+        complete(p, true, std::move(reply));
+    }
+
+    std::unordered_map<std::uint64_t, Pending> orphans;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        finished = true;
+        orphans.swap(pending);
+    }
+    slotFree.notify_all();
+    for (auto& [_, p] : orphans)
+        complete(p, false, {});
+}
+
+void RpcChannel::close() {
+    bool sendClose = false;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!closing) {
+            closing = true;
+            sendClose = !finished;
+        }
+    }
+    slotFree.notify_all();
+    // If the close frame cannot be written the peer is gone: a pipe or
+    // socket reader stops at EOF instead of at the acknowledgement, and a
+    // queue reader is interrupted without waiting for one.
+    bool handshake = true;
+    if (sendClose) {
+        int timeoutMs = link.interruptible() ? static_cast<int>(closeGrace.count()) : -1;
+        handshake = link.send(0, {}, timeoutMs);
+    }
+    if (!handshake && link.interruptible())
+        link.interrupt();
+
+    // A callback runs on the reader thread, which cannot join itself; it
+    // stops on its own once the acknowledgement arrives.
+    if (std::this_thread::get_id() == reader.get_id())
+        return;
+
+    if (handshake && link.interruptible()) {
+        std::unique_lock<std::mutex> guard(lock);
+        if (!slotFree.wait_for(guard, closeGrace, [this] { return finished; })) {
+            guard.unlock();
+            link.interrupt();
+        }
+    }
+    if (reader.joinable())
+        reader.join();
+}
+
+void RpcServer::serve(const std::function<std::string(std::string_view)>& handler) {
+    std::uint64_t id;
+    std::string request;
+    while (link.receive(id, request)) {
+        if (id == 0) {
+            link.send(0, {});
+            return;
+        }
+        if (!link.send(id, handler(request)))
+            return;
+    }
+}
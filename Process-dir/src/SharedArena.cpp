@@ -0,0 +1,190 @@
+// This is a demo version of PVS-Studio for educational use.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: https://pvs-studio.com
+#include "../include/SharedArena.h"
+#include <atomic>
+#include <thread>
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "SharedArena needs lock-free atomics in shared memory");
+
+static constexpr uint64_t ARENA_MAGIC = 0x414e455241485331ULL; // "1SHARENA"
+static constexpr size_t MIN_CLASS = 16;
+static constexpr int NUM_CLASSES = 13;          // 16 B .. 64 KiB
+static constexpr uint64_t LARGE_CLASS = NUM_CLASSES;
+static constexpr size_t ALIGN = 16;
+
+struct SharedArena::Header {
+    uint64_t magic;
+    uint64_t size;
+    std::atomic<uint32_t> lock;
+    uint64_t top;                       // bump pointer for fresh blocks
+    uint64_t used;
+    std::atomic<uint64_t> root;
+    uint64_t freeLists[NUM_CLASSES + 1]; // last entry: large blocks
+};
+
+// Precedes every block; 'next' links free blocks of the same class.
+struct BlockHeader {
+    uint64_t size;       // usable bytes
+    uint64_t sizeClass;
+    uint64_t next;
+    uint64_t reserved;
+};
+
+static size_t align_up(size_t v, size_t a) { return (v + a - 1) / a * a; }
+
+static int class_for(size_t bytes) {
+    size_t c = MIN_CLASS;
+    for (int i = 0; i < NUM_CLASSES; i++, c <<= 1)
+        if (bytes <= c) return i;
+    return -1;
+}
+
+SharedArena::SharedArena() = default;
+SharedArena::~SharedArena() { close(); }
+
+bool SharedArena::create(const std::string& name, size_t size) {
+    return attach(name, size, true);
+}
+
+bool SharedArena::open(const std::string& name, size_t size) {
+    return attach(name, size, false);
+}
+
+bool SharedArena::attach(const std::string& name, size_t size, bool create) {
+    close();
+    if (size < align_up(sizeof(Header), ALIGN) + sizeof(BlockHeader) + MIN_CLASS) return false;
+
+    bool ok = create ? shm.create(name, size) : shm.open(name, size);
+    if (!ok || !shm.getBuffer()) return false;
+
+    base = static_cast<char*>(shm.getBuffer());
+    header = reinterpret_cast<Header*>(base);
+
+    if (create) {
+        new (header) Header{};
+        header->size = size;
+        header->top = align_up(sizeof(Header), ALIGN);
+        header->lock.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        header->magic = ARENA_MAGIC;
+    } else {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->magic != ARENA_MAGIC || header->size != size) {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void SharedArena::close() {
+    shm.close();
+    header = nullptr;
+    base = nullptr;
+}
+
+void SharedArena::lock() const {
+    uint32_t expected = 0;
+    while (!header->lock.compare_exchange_weak(expected, 1, std::memory_order_acquire)) {
+        expected = 0;
+        std::this_thread::yield();
+    }
+}
+
+void SharedArena::unlock() const {
+    header->lock.store(0, std::memory_order_release);
+}
+
+SharedArena::offset_t SharedArena::allocate(size_t bytes) {
+    // Larger than the whole arena can never fit, and near SIZE_MAX the
+    // rounding below would wrap to a tiny block.
+    if (!header || bytes == 0 || bytes > header->size) return 0;
+
+    int cls = class_for(bytes);
+    size_t blockSize = cls >= 0 ? MIN_CLASS << cls : align_up(bytes, ALIGN);
+    uint64_t listIdx = cls >= 0 ? static_cast<uint64_t>(cls) : LARGE_CLASS;
+
+    lock();
+
+    offset_t blockOff = 0;
+    if (cls >= 0) {
+        blockOff = header->freeLists[listIdx];
+        if (blockOff) {
+            auto* b = reinterpret_cast<BlockHeader*>(base + blockOff);
+            header->freeLists[listIdx] = b->next;
+        }
+    } else {
+        // First fit among freed large blocks.
+        uint64_t* link = &header->freeLists[LARGE_CLASS];
+        while (*link) {
+            auto* b = reinterpret_cast<BlockHeader*>(base + *link);
+            if (b->size >= blockSize) {
+                blockOff = *link;
+                *link = b->next;
+                blockSize = b->size;
+                break;
+            }
+            link = &b->next;
+        }
+    }
+
+    if (!blockOff) {
+        size_t need = sizeof(BlockHeader) + blockSize;
+        if (header->top + need > header->size) {
+            unlock();
+            return 0;
+        }
+        blockOff = header->top;
+        header->top += need;
+    }
+
+    auto* b = reinterpret_cast<BlockHeader*>(base + blockOff);
+    b->size = blockSize;
+    b->sizeClass = listIdx;
+    b->next = 0;
+    header->used += blockSize;
+
+    unlock();
+    return blockOff + sizeof(BlockHeader);
+}
+
+void SharedArena::deallocate(offset_t off) {
+    if (!header || off < sizeof(BlockHeader)) return;
+
+    offset_t blockOff = off - sizeof(BlockHeader);
+    auto* b = reinterpret_cast<BlockHeader*>(base + blockOff);
+
+    lock();
+    b->next = header->freeLists[b->sizeClass];
+    header->freeLists[b->sizeClass] = blockOff;
+    header->used -= b->size;
+    unlock();
+}
+
+void* SharedArena::get(offset_t off) const {
+    return (base && off) ? base + off : nullptr;
+}
+
+SharedArena::offset_t SharedArena::offsetOf(const void* p) const {
+    if (!base || !p) return 0;
+    return static_cast<offset_t>(static_cast<const char*>(p) - base);
+}
+
+void SharedArena::setRoot(offset_t off) {
+    if (!header) return;
+    header->root.store(off, std::memory_order_release);
+}
+
+SharedArena::offset_t SharedArena::root() const {
+    if (!header) return 0;
+    return header->root.load(std::memory_order_acquire);
+}
+
+size_t SharedArena::used() const {
+    if (!header) return 0;
+    lock();
+    size_t u = header->used;
+    unlock();
+    return u;
+}
@@ -0,0 +1,112 @@
+// This is a demo version of PVS-Studio for educational use.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: https://pvs-studio.com
+#include "../include/SharedBroadcast.h"
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <new>
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "SharedBroadcast needs lock-free 64-bit atomics in shared memory");
+
+static constexpr uint64_t BROADCAST_MAGIC = 0x5453414344414f52ULL; // "ROADCAST"
+static constexpr size_t HEADER_SIZE = 64;
+
+struct SharedBroadcast::Header {
+    uint64_t magic;
+    uint64_t capacity;
+    std::atomic<uint64_t> sequence;  // odd while a publish is in progress
+    std::atomic<uint64_t> length;
+};
+
+SharedBroadcast::SharedBroadcast() = default;
+SharedBroadcast::~SharedBroadcast() { close(); }
+
+bool SharedBroadcast::create(const std::string& name, size_t capacity) {
+    return attach(name, capacity, true);
+}
+
+bool SharedBroadcast::open(const std::string& name, size_t capacity) {
+    return attach(name, capacity, false);
+}
+
+bool SharedBroadcast::attach(const std::string& name, size_t capacity, bool create) {
+    static_assert(sizeof(Header) <= HEADER_SIZE, "header does not fit");
+    close();
+    if (capacity == 0) return false;
+
+    bool ok = create ? shm.create(name, HEADER_SIZE + capacity) : shm.open(name, HEADER_SIZE + capacity);
+    if (!ok || !shm.getBuffer()) return false;
+
+    header = static_cast<Header*>(shm.getBuffer());
+    data = static_cast<char*>(shm.getBuffer()) + HEADER_SIZE;
+    cap = capacity;
+
+    if (create) {
+        new (header) Header{};
+        header->capacity = capacity;
+        header->sequence.store(0, std::memory_order_relaxed);
+        header->length.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        header->magic = BROADCAST_MAGIC;
+    } else {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->magic != BROADCAST_MAGIC || header->capacity != capacity) {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void SharedBroadcast::close() {
+    shm.close();
+    header = nullptr;
+    data = nullptr;
+    cap = 0;
+}
+
+bool SharedBroadcast::publish(const void* src, size_t len) {
+    if (!header || len > cap) return false;
+
+    uint64_t seq = header->sequence.load(std::memory_order_relaxed);
+    header->sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::memcpy(data, src, len);
+    header->length.store(len, std::memory_order_relaxed);
+
+    header->sequence.store(seq + 2, std::memory_order_release);
+    return true;
+}
+
+uint64_t SharedBroadcast::read(std::string& out) const {
+    if (!header) return 0;
+
+    for (;;) {
+        uint64_t before = header->sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        size_t len = header->length.load(std::memory_order_relaxed);
+        if (len > cap) continue;
+        out.assign(data, len);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->sequence.load(std::memory_order_relaxed) == before)
+            return before / 2;
+    }
+}
+
+bool SharedBroadcast::readIfNewer(uint64_t& lastVersion, std::string& out) const {
+    if (version() <= lastVersion) return false;
+    lastVersion = read(out);
+    return true;
+}
+
+uint64_t SharedBroadcast::version() const {
+    if (!header) return 0;
+    return header->sequence.load(std::memory_order_acquire) / 2;
+}
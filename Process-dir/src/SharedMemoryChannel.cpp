@@ -13,7 +13,24 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <cstdlib>
+#include <cerrno>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
 #endif
+#endif
+
+// "fd:<n>" names refer to a descriptor inherited from the parent
+// (SharedMemoryMode::Anonymous) instead of a shm_open object.
+static bool parse_fd_name(const std::string& n, int& fdOut) {
+    if (n.compare(0, 3, "fd:") != 0 || n.size() == 3) return false;
+    char* end = nullptr;
+    long v = std::strtol(n.c_str() + 3, &end, 10);
+    if (*end != '\0' || v < 0) return false;
+    fdOut = static_cast<int>(v);
+    return true;
+}
 
 SharedMemoryChannel::SharedMemoryChannel() = default;
 SharedMemoryChannel::~SharedMemoryChannel() { close(); }
@@ -60,6 +77,8 @@ bool SharedMemoryChannel::create(const std::string& n, size_t sz) {
     // POSIX
     fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0666);
     if (fd == -1) return false;
+    named = true;
+    owner = true;
 
     if (ftruncate(fd, size) == -1) return false;
 
@@ -97,12 +116,14 @@ bool SharedMemoryChannel::open(const std::string& n, size_t sz) {
 
     hMap = h;
 
+    // Map the whole section, which may be larger than 'size' if the creator
+    // made it so; the view covers it rounded up to whole pages.
     buffer = MapViewOfFile(
         hMap,
         FILE_MAP_ALL_ACCESS,
         0,
         0,
-        size
+        0
     );
 
     if (!buffer) {
@@ -112,15 +133,38 @@ bool SharedMemoryChannel::open(const std::string& n, size_t sz) {
         return false;
     }
 
+    MEMORY_BASIC_INFORMATION info{};
+    if (VirtualQuery(buffer, &info, sizeof(info)) && info.RegionSize > size)
+        size = info.RegionSize;
+
     return true;
 #else
     // POSIX
-    fd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0666);
-    if (fd == -1) {
-        perror("shm_open (open) failed");
-        return false;
+    int inherited = -1;
+    owner = false;
+    if (parse_fd_name(name, inherited)) {
+        fd = inherited;
+        named = false;
+    } else {
+        // Attach to an existing object; only if there is none do we create
+        // (and then own) it, so a reader closing does not unlink a segment
+        // other processes are still attaching to.
+        fd = shm_open(name.c_str(), O_RDWR, 0666);
+        if (fd == -1 && errno == ENOENT) {
+            fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666);
+            owner = fd != -1;
+            if (fd == -1 && errno == EEXIST)
+                fd = shm_open(name.c_str(), O_RDWR, 0666);
+        }
+        if (fd == -1) {
+            perror("shm_open (open) failed");
+            return false;
+        }
+        named = true;
     }
 
+    // The creator's size wins: a segment bigger than the caller expects is
+    // mapped whole, so readers need not know how large the writer made it.
     struct stat st;
     fstat(fd, &st);
     if (st.st_size < (off_t)size) {
@@ -128,10 +172,13 @@ bool SharedMemoryChannel::open(const std::string& n, size_t sz) {
             perror("ftruncate failed");
             return false;
         }
+    } else {
+        size = static_cast<size_t>(st.st_size);
     }
 
     buffer = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
     if (buffer == MAP_FAILED) {
+        buffer = nullptr;
         perror("mmap failed");
         return false;
     }
@@ -140,6 +187,102 @@ bool SharedMemoryChannel::open(const std::string& n, size_t sz) {
 #endif
 }
 
+bool SharedMemoryChannel::createAnonymous(size_t sz) {
+    name.clear();
+    size = sz;
+    named = false;
+    owner = false;
+
+#ifdef _WIN32
+    SECURITY_ATTRIBUTES sa{};
+    sa.nLength = sizeof(sa);
+    sa.bInheritHandle = TRUE;
+
+    HANDLE h = CreateFileMappingA(INVALID_HANDLE_VALUE, &sa, PAGE_READWRITE,
+                                  0, static_cast<DWORD>(size), nullptr);
+    if (!h) {
+        std::cerr << "CreateFileMappingA (anonymous) failed. Error: " << GetLastError() << "\n";
+        return false;
+    }
+    hMap = h;
+
+    buffer = MapViewOfFile(hMap, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!buffer) {
+        CloseHandle(static_cast<HANDLE>(hMap));
+        hMap = nullptr;
+        return false;
+    }
+    return true;
+#else
+#ifdef __linux__
+    fd = memfd_create("ipc_shm", MFD_CLOEXEC);
+#else
+    // No memfd: create a private shm object and unlink it right away, so
+    // only the descriptor keeps it alive.
+    static unsigned counter = 0;
+    std::string tmp = "/ipc_anon_" + std::to_string(getpid()) + "_" + std::to_string(counter++);
+    fd = shm_open(tmp.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd != -1) {
+        shm_unlink(tmp.c_str());
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+#endif
+    if (fd == -1) {
+        perror("memfd_create failed");
+        return false;
+    }
+
+    if (ftruncate(fd, size) == -1) {
+        perror("ftruncate failed");
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    buffer = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (buffer == MAP_FAILED) {
+        perror("mmap failed");
+        buffer = nullptr;
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    return true;
+#endif
+}
+
+#if !defined(_WIN32) && defined(__linux__) && defined(SYS_mbind)
+static bool apply_mbind(void* addr, size_t len, int mode, const unsigned long* mask, unsigned long maxnode) {
+    return syscall(SYS_mbind, addr, len, mode, mask, maxnode, 0) == 0;
+}
+#endif
+
+bool SharedMemoryChannel::bindToNumaNode(int node) {
+#if !defined(_WIN32) && defined(__linux__) && defined(SYS_mbind)
+    if (!buffer || node < 0 || node >= 1024) return false;
+    unsigned long mask[1024 / (8 * sizeof(unsigned long))] = {};
+    mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+    // Preferred rather than strict binding, so a full node degrades to
+    // remote pages instead of failing the fault.
+    return apply_mbind(buffer, size, MPOL_PREFERRED, mask, 1024);
+#else
+    (void)node;
+    return false;
+#endif
+}
+
+bool SharedMemoryChannel::interleaveNumaNodes() {
+#if !defined(_WIN32) && defined(__linux__) && defined(SYS_mbind)
+    if (!buffer) return false;
+    // The kernel trims the mask to nodes that exist and are allowed.
+    unsigned long mask[1024 / (8 * sizeof(unsigned long))];
+    for (auto& m : mask) m = ~0UL;
+    return apply_mbind(buffer, size, MPOL_INTERLEAVE, mask, 1024);
+#else
+    return false;
+#endif
+}
+
 bool SharedMemoryChannel::write(const std::string& data) {
     if (!buffer) return false;
 
@@ -147,13 +290,16 @@ bool SharedMemoryChannel::write(const std::string& data) {
     memcpy(buffer, data.data(), copySize);
 
     ((char*)buffer)[copySize] = '\0';
+    channelCounters.wrote(copySize);
 
     return true;
 }
 
 std::string SharedMemoryChannel::read() {
     if (!buffer) return "";
-    return std::string((char*)buffer);
+    std::string data((char*)buffer);
+    channelCounters.read(data.size());
+    return data;
 }
 
 void SharedMemoryChannel::close() {
@@ -172,8 +318,12 @@ void SharedMemoryChannel::close() {
         buffer = nullptr;
     }
     if (fd != -1) {
-        shm_unlink(name.c_str());
+        if (named && owner)
+            shm_unlink(name.c_str());
+        ::close(fd);
         fd = -1;
+        named = false;
+        owner = false;
     }
 #endif
 }
\ No newline at end of file
@@ -0,0 +1,37 @@
+// This is a demo version of PVS-Studio for educational use.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: https://pvs-studio.com
+#include "../include/SharedMemoryRegistry.h"
+
+#ifdef _WIN32
+#include <windows.h>
+static unsigned long current_pid() { return GetCurrentProcessId(); }
+#else
+#include <unistd.h>
+static unsigned long current_pid() { return static_cast<unsigned long>(getpid()); }
+#endif
+
+SharedMemoryRegistry& SharedMemoryRegistry::instance() {
+    static SharedMemoryRegistry registry;
+    return registry;
+}
+
+unsigned long SharedMemoryRegistry::acquire() {
+    std::lock_guard<std::mutex> lock(mtx);
+    unsigned long id = nextId++;
+    live.insert(id);
+    return id;
+}
+
+void SharedMemoryRegistry::release(unsigned long id) {
+    std::lock_guard<std::mutex> lock(mtx);
+    live.erase(id);
+}
+
+std::string SharedMemoryRegistry::name(const std::string& kind, unsigned long id) const {
+    return "/proc_" + kind + "_" + std::to_string(current_pid()) + "_" + std::to_string(id);
+}
+
+size_t SharedMemoryRegistry::active() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return live.size();
+}
@@ -1,9 +1,11 @@
 // This is a demo version of PVS-Studio for educational use.
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: https://pvs-studio.com
 #include "../include/SharedSemaphore.h"
+#include "../include/Tracing.h"
 #include <stdexcept>
 #include <string>
 #include <iostream>
+#include <chrono>
 
 #ifdef _WIN32
 SharedSemaphore::SharedSemaphore() : hSem(NULL), creator(false) {}
@@ -19,6 +21,10 @@ SharedSemaphore::~SharedSemaphore() {
         CloseHandle(hSem);
         hSem = NULL;
     }
+    if (hClosed) {
+        CloseHandle(hClosed);
+        hClosed = NULL;
+    }
 }
 
 void SharedSemaphore::init(const std::string& name, bool create, int initialValue) {
@@ -26,6 +32,10 @@ void SharedSemaphore::init(const std::string& name, bool create, int initialValu
         CloseHandle(hSem);
         hSem = NULL;
     }
+    if (hClosed) {
+        CloseHandle(hClosed);
+        hClosed = NULL;
+    }
     std::string safeName = name;
     for (auto &c : safeName) {
         if (c == '/' || c == '\\') c = '_';
@@ -46,20 +56,75 @@ void SharedSemaphore::init(const std::string& name, bool create, int initialValu
         }
         creator = false;
     }
+
+    hClosed = CreateEventA(NULL, TRUE, FALSE, (safeName + "_closed").c_str());
+    if (!hClosed)
+        throw std::runtime_error("CreateEventA failed. Error: " + std::to_string(GetLastError()));
+    if (create)
+        ResetEvent(hClosed);
+}
+
+void SharedSemaphore::initAnonymous(int initialValue) {
+    if (hSem) {
+        CloseHandle(hSem);
+        hSem = NULL;
+    }
+    SECURITY_ATTRIBUTES sa{};
+    sa.nLength = sizeof(sa);
+    sa.bInheritHandle = TRUE;
+
+    if (hClosed) {
+        CloseHandle(hClosed);
+        hClosed = NULL;
+    }
+    hSem = CreateSemaphoreA(&sa, initialValue, 2147483647, NULL);
+    if (!hSem)
+        throw std::runtime_error("CreateSemaphoreA (anonymous) failed. Error: " + std::to_string(GetLastError()));
+    hClosed = CreateEventA(&sa, TRUE, FALSE, NULL);
+    if (!hClosed)
+        throw std::runtime_error("CreateEventA (anonymous) failed. Error: " + std::to_string(GetLastError()));
+    creator = true;
+}
+
+// The semaphore comes first in the handle list, so a pending count is
+// always consumed before the closed event is reported.
+bool SharedSemaphore::wait() {
+    return waitFor(-1);
 }
 
-void SharedSemaphore::wait() {
+bool SharedSemaphore::waitFor(int timeoutMs) {
     if (!hSem) throw std::runtime_error("Semaphore not initialized");
-    WaitForSingleObject(hSem, INFINITE);
+    HANDLE handles[2] = { hSem, hClosed };
+    DWORD r = WaitForMultipleObjects(hClosed ? 2 : 1, handles, FALSE, 0);
+    if (r == WAIT_TIMEOUT && timeoutMs != 0) {
+        auto started = std::chrono::steady_clock::now();
+        r = WaitForMultipleObjects(hClosed ? 2 : 1, handles, FALSE,
+                                   timeoutMs < 0 ? INFINITE : static_cast<DWORD>(timeoutMs));
+        channelCounters.waited(std::chrono::steady_clock::now() - started);
+    }
+    if (r != WAIT_OBJECT_0) return false;
+    channelCounters.read(0);
+    return true;
+}
+
+void SharedSemaphore::shutdown() {
+    if (hClosed) SetEvent(hClosed);
+}
+
+bool SharedSemaphore::isShutdown() const {
+    return hClosed && WaitForSingleObject(hClosed, 0) == WAIT_OBJECT_0;
 }
 
 void SharedSemaphore::post() {
     if (!hSem) throw std::runtime_error("Semaphore not initialized");
     ReleaseSemaphore(hSem, 1, NULL);
+    channelCounters.wrote(0);
 }
 
 #else
 #include <cstring>
+#include <cerrno>
+#include <ctime>
 #include <unistd.h>
 #include <new> 
 
@@ -90,6 +155,25 @@ void SharedSemaphore::init(const std::string& name, bool create, int initialValu
         creator = false;
     }
 
+    setup(initialValue);
+}
+
+void SharedSemaphore::initAnonymous(int initialValue)
+{
+    if (data) {
+        this->~SharedSemaphore();
+        new (this) SharedSemaphore();
+    }
+
+    if (!shm.createAnonymous(4096))
+        throw std::runtime_error("Failed to create anonymous semaphore segment");
+    creator = true;
+
+    setup(initialValue);
+}
+
+void SharedSemaphore::setup(int initialValue)
+{
     data = reinterpret_cast<SemaphoreData*>(shm.getBuffer());
 
     if (!data)
@@ -126,16 +210,77 @@ SharedSemaphore::~SharedSemaphore() {
 }
 
 
-void SharedSemaphore::wait() {
-    if (!data) return;
+bool SharedSemaphore::wait() {
+    if (!data) return false;
+    PROCESS_TRACE1(sem_wait__entry, data);
     pthread_mutex_lock(&data->mtx);
 
-    while (data->value == 0)
-        pthread_cond_wait(&data->cond, &data->mtx);
+    if (data->value == 0 && !data->closed) {
+        auto started = std::chrono::steady_clock::now();
+        while (data->value == 0 && !data->closed)
+            pthread_cond_wait(&data->cond, &data->mtx);
+        channelCounters.waited(std::chrono::steady_clock::now() - started);
+    }
 
-    data->value--;
+    bool acquired = data->value > 0;
+    if (acquired)
+        data->value--;
 
     pthread_mutex_unlock(&data->mtx);
+    if (acquired) channelCounters.read(0);
+    PROCESS_TRACE2(sem_wait__return, data, acquired);
+    return acquired;
+}
+
+bool SharedSemaphore::waitFor(int timeoutMs) {
+    if (timeoutMs < 0) return wait();
+    if (!data) return false;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec  += timeoutMs / 1000;
+    deadline.tv_nsec += static_cast<long>(timeoutMs % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    PROCESS_TRACE1(sem_wait__entry, data);
+    pthread_mutex_lock(&data->mtx);
+
+    if (data->value == 0 && !data->closed && timeoutMs > 0) {
+        auto started = std::chrono::steady_clock::now();
+        while (data->value == 0 && !data->closed) {
+            if (pthread_cond_timedwait(&data->cond, &data->mtx, &deadline) == ETIMEDOUT)
+                break;
+        }
+        channelCounters.waited(std::chrono::steady_clock::now() - started);
+    }
+
+    bool acquired = data->value > 0;
+    if (acquired)
+        data->value--;
+
+    pthread_mutex_unlock(&data->mtx);
+    if (acquired) channelCounters.read(0);
+    PROCESS_TRACE2(sem_wait__return, data, acquired);
+    return acquired;
+}
+
+void SharedSemaphore::shutdown() {
+    if (!data) return;
+    pthread_mutex_lock(&data->mtx);
+    data->closed = 1;
+    pthread_cond_broadcast(&data->cond);
+    pthread_mutex_unlock(&data->mtx);
+}
+
+bool SharedSemaphore::isShutdown() const {
+    if (!data) return true;
+    pthread_mutex_lock(&data->mtx);
+    bool closed = data->closed && data->value == 0;
+    pthread_mutex_unlock(&data->mtx);
+    return closed;
 }
 
 void SharedSemaphore::post() {
@@ -146,5 +291,7 @@ void SharedSemaphore::post() {
     pthread_cond_signal(&data->cond);
 
     pthread_mutex_unlock(&data->mtx);
+    channelCounters.wrote(0);
+    PROCESS_TRACE1(sem_post, data);
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,159 @@
+// This is a demo version of PVS-Studio for educational use.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: https://pvs-studio.com
+#include "../include/SharedTripleBuffer.h"
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <cstddef>
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "SharedTripleBuffer needs lock-free 32-bit atomics in shared memory");
+
+static constexpr uint64_t TRIPLE_MAGIC = 0x3346465542504952ULL; // "RIPBUFF3"
+static constexpr uint32_t INDEX_MASK = 3;
+static constexpr uint32_t FRESH = 4;     // middle holds a frame the reader has not taken
+static constexpr size_t SLOT_HEADER = 64;
+
+struct SharedTripleBuffer::Header {
+    uint64_t magic;
+    uint64_t capacity;
+    alignas(64) std::atomic<uint32_t> middle;
+    // The reader's buffer, kept here rather than only in the reader so that
+    // a reader attaching later takes over the right one.
+    alignas(64) std::atomic<uint32_t> reader;
+};
+
+// Written only by the side that owns the buffer; the exchange on 'middle'
+// publishes it to the other side.
+struct SharedTripleBuffer::Slot {
+    uint64_t length;
+    uint64_t frame;
+    alignas(64) char data[1];
+};
+
+SharedTripleBuffer::SharedTripleBuffer() = default;
+SharedTripleBuffer::~SharedTripleBuffer() { close(); }
+
+bool SharedTripleBuffer::create(const std::string& name, size_t capacity) {
+    return attach(name, capacity, true);
+}
+
+bool SharedTripleBuffer::open(const std::string& name, size_t capacity) {
+    return attach(name, capacity, false);
+}
+
+bool SharedTripleBuffer::attach(const std::string& name, size_t capacity, bool create) {
+    static_assert(offsetof(Slot, data) == SLOT_HEADER, "slot header size changed");
+    close();
+    if (capacity == 0) return false;
+
+    size_t slotBytes = (SLOT_HEADER + capacity + 63) & ~size_t(63);
+    size_t total = sizeof(Header) + 3 * slotBytes;
+    bool ok = create ? shm.create(name, total) : shm.open(name, total);
+    if (!ok || !shm.getBuffer()) return false;
+
+    header = static_cast<Header*>(shm.getBuffer());
+    slots = static_cast<char*>(shm.getBuffer()) + sizeof(Header);
+    cap = capacity;
+    stride = slotBytes;
+
+    // The writer starts on buffer 0, the middle is 1, the reader holds 2.
+    if (create) {
+        new (header) Header{};
+        header->capacity = capacity;
+        header->middle.store(1, std::memory_order_relaxed);
+        header->reader.store(2, std::memory_order_relaxed);
+        for (unsigned i = 0; i < 3; i++) {
+            slot(i)->length = 0;
+            slot(i)->frame = 0;
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        header->magic = TRIPLE_MAGIC;
+        writer = true;
+        own = 0;
+    } else {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->magic != TRIPLE_MAGIC || header->capacity != capacity) {
+            close();
+            return false;
+        }
+        writer = false;
+        own = header->reader.load(std::memory_order_acquire) & INDEX_MASK;
+    }
+    return true;
+}
+
+void SharedTripleBuffer::close() {
+    shm.close();
+    header = nullptr;
+    slots = nullptr;
+    cap = 0;
+    stride = 0;
+    framesWritten = 0;
+    framesSkipped = 0;
+}
+
+SharedTripleBuffer::Slot* SharedTripleBuffer::slot(unsigned index) const {
+    return reinterpret_cast<Slot*>(slots + index * stride);
+}
+
+void* SharedTripleBuffer::writeBuffer() {
+    if (!header || !writer) return nullptr;
+    return slot(own)->data;
+}
+
+bool SharedTripleBuffer::commit(size_t len) {
+    if (!header || !writer || len > cap) return false;
+
+    Slot* s = slot(own);
+    s->length = len;
+    s->frame = ++framesWritten;
+    // Release our frame into the middle; whatever was there (fresh or not)
+    // becomes our next back buffer.
+    uint32_t old = header->middle.exchange(own | FRESH, std::memory_order_acq_rel);
+    own = old & INDEX_MASK;
+    return true;
+}
+
+bool SharedTripleBuffer::publish(const void* data, size_t len) {
+    if (!header || !writer || len > cap) return false;
+    std::memcpy(slot(own)->data, data, len);
+    return commit(len);
+}
+
+bool SharedTripleBuffer::acquire() {
+    if (!header || writer) return false;
+    if (!(header->middle.load(std::memory_order_relaxed) & FRESH))
+        return false;
+
+    uint64_t previous = slot(own)->frame;
+    uint32_t old = header->middle.exchange(own, std::memory_order_acq_rel);
+    own = old & INDEX_MASK;
+    header->reader.store(own, std::memory_order_release);
+
+    uint64_t frame = slot(own)->frame;
+    if (frame > previous + 1)
+        framesSkipped += frame - previous - 1;
+    return true;
+}
+
+const void* SharedTripleBuffer::frontData() const {
+    if (!header || writer) return nullptr;
+    return slot(own)->data;
+}
+
+size_t SharedTripleBuffer::frontSize() const {
+    if (!header || writer) return 0;
+    return static_cast<size_t>(slot(own)->length);
+}
+
+uint64_t SharedTripleBuffer::frontFrame() const {
+    if (!header || writer) return 0;
+    return slot(own)->frame;
+}
+
+bool SharedTripleBuffer::readLatest(std::string& out) {
+    if (!acquire()) return false;
+    out.assign(static_cast<const char*>(frontData()), frontSize());
+    return true;
+}
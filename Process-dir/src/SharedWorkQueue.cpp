@@ -0,0 +1,242 @@
+// This is a demo version of PVS-Studio for educational use.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: https://pvs-studio.com
+#include "../include/SharedWorkQueue.h"
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <new>
+#include <cstddef>
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "SharedWorkQueue needs lock-free 64-bit atomics in shared memory");
+
+static constexpr uint64_t QUEUE_MAGIC = 0x5157514d50435131ULL; // "1QCPMQWQ"
+static constexpr size_t CACHE_LINE = 64;
+
+struct SharedWorkQueue::Header {
+    uint64_t magic;
+    uint64_t capacity;
+    uint64_t slotSize;
+    uint64_t tag;
+    alignas(CACHE_LINE) std::atomic<uint64_t> enqueuePos;
+    alignas(CACHE_LINE) std::atomic<uint64_t> dequeuePos;
+    alignas(CACHE_LINE) std::atomic<uint32_t> sleepers;
+    std::atomic<uint32_t> closed;
+};
+
+struct SharedWorkQueue::Slot {
+    std::atomic<uint64_t> sequence;
+    uint32_t length;
+    char data[1];
+};
+
+static size_t round_up_pow2(size_t v) {
+    size_t p = 1;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+SharedWorkQueue::SharedWorkQueue() = default;
+SharedWorkQueue::~SharedWorkQueue() { close(); }
+
+bool SharedWorkQueue::create(const std::string& name, size_t capacity, size_t slotSize, uint64_t tag) {
+    return attach(name, capacity, slotSize, tag, true);
+}
+
+bool SharedWorkQueue::open(const std::string& name, size_t capacity, size_t slotSize, uint64_t tag) {
+    return attach(name, capacity, slotSize, tag, false);
+}
+
+bool SharedWorkQueue::attach(const std::string& name, size_t capacity, size_t slotSize, uint64_t tag, bool create) {
+    close();
+    if (capacity == 0 || slotSize == 0 || slotSize > UINT32_MAX) return false;
+
+    cap = round_up_pow2(capacity);
+    payload = slotSize;
+    stride = (offsetof(Slot, data) + slotSize + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    size_t headerSize = (sizeof(Header) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    size_t total = headerSize + cap * stride;
+
+    bool ok = create ? shm.create(name, total) : shm.open(name, total);
+    if (!ok || !shm.getBuffer()) return false;
+
+    header = static_cast<Header*>(shm.getBuffer());
+    slots = static_cast<char*>(shm.getBuffer()) + headerSize;
+
+    if (create) {
+        new (header) Header{};
+        header->capacity = cap;
+        header->slotSize = payload;
+        header->tag = tag;
+        header->enqueuePos.store(0, std::memory_order_relaxed);
+        header->dequeuePos.store(0, std::memory_order_relaxed);
+        header->sleepers.store(0, std::memory_order_relaxed);
+        header->closed.store(0, std::memory_order_relaxed);
+        for (size_t i = 0; i < cap; i++) {
+            Slot* s = new (slots + i * stride) Slot;
+            s->sequence.store(i, std::memory_order_relaxed);
+            s->length = 0;
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        header->magic = QUEUE_MAGIC;
+
+        notEmpty.init(name + "_wait", true, 0);
+    } else {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->magic != QUEUE_MAGIC || header->capacity != cap || header->slotSize != payload ||
+            header->tag != tag) {
+            close();
+            return false;
+        }
+        notEmpty.init(name + "_wait", false);
+    }
+    return true;
+}
+
+void SharedWorkQueue::close() {
+    shm.close();
+    header = nullptr;
+    slots = nullptr;
+}
+
+SharedWorkQueue::Slot* SharedWorkQueue::slotAt(uint64_t pos) const {
+    return reinterpret_cast<Slot*>(slots + (pos & (cap - 1)) * stride);
+}
+
+bool SharedWorkQueue::tryPush(const void* data, size_t len) {
+    if (!header || len > payload) return false;
+    if (header->closed.load(std::memory_order_acquire)) return false;
+
+    uint64_t pos = header->enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot* s = slotAt(pos);
+        uint64_t seq = s->sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+        if (diff == 0) {
+            if (header->enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                std::memcpy(s->data, data, len);
+                s->length = static_cast<uint32_t>(len);
+                s->sequence.store(pos + 1, std::memory_order_release);
+                wakeConsumer();
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;  // full
+        } else {
+            pos = header->enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool SharedWorkQueue::tryPop(void* out, size_t outSize, size_t& len) {
+    if (!header) return false;
+
+    uint64_t pos = header->dequeuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot* s = slotAt(pos);
+        uint64_t seq = s->sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos + 1);
+        if (diff == 0) {
+            if (s->length > outSize)
+                throw std::runtime_error("SharedWorkQueue item exceeds the output buffer");
+            if (header->dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                len = s->length;
+                std::memcpy(out, s->data, len);
+                s->sequence.store(pos + cap, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;  // empty
+        } else {
+            pos = header->dequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+uint64_t SharedWorkQueue::tag() const {
+    return header ? header->tag : 0;
+}
+
+bool SharedWorkQueue::tryPop(std::string& out) {
+    out.resize(payload);
+    size_t len = 0;
+    if (!tryPop(out.data(), out.size(), len)) {
+        out.clear();
+        return false;
+    }
+    out.resize(len);
+    return true;
+}
+
+// A producer only touches the semaphore when some consumer has announced
+// that it is about to sleep; the seq_cst fence pairs with the fetch_add in
+// pop() so that either the consumer sees the new item or we see it waiting.
+void SharedWorkQueue::wakeConsumer() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (header->sleepers.load(std::memory_order_relaxed) > 0)
+        notEmpty.post();
+}
+
+void SharedWorkQueue::push(const std::string& data) {
+    push(data.data(), data.size());
+}
+
+void SharedWorkQueue::push(const void* data, size_t len) {
+    if (!header) throw std::runtime_error("SharedWorkQueue not open");
+    if (len > payload) throw std::runtime_error("SharedWorkQueue message exceeds slot size");
+    while (!tryPush(data, len)) {
+        if (header->closed.load(std::memory_order_acquire))
+            throw std::runtime_error("SharedWorkQueue is shut down");
+        std::this_thread::yield();
+    }
+}
+
+std::string SharedWorkQueue::pop() {
+    std::string out(payload, '\0');
+    out.resize(pop(out.data(), out.size()));
+    return out;
+}
+
+size_t SharedWorkQueue::pop(void* out, size_t outSize) {
+    size_t len = 0;
+    return pop(out, outSize, len, -1) ? len : 0;
+}
+
+bool SharedWorkQueue::pop(void* out, size_t outSize, size_t& len, int timeoutMs) {
+    if (!header) throw std::runtime_error("SharedWorkQueue not open");
+
+    for (int spin = 0; spin < 64; spin++) {
+        if (tryPop(out, outSize, len)) return true;
+    }
+
+    for (;;) {
+        header->sleepers.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (tryPop(out, outSize, len)) {
+            header->sleepers.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        // shutdown() sets the flag before waking, so a consumer that
+        // missed the wakeup sees the flag here.
+        if (header->closed.load(std::memory_order_acquire)) {
+            header->sleepers.fetch_sub(1, std::memory_order_relaxed);
+            return tryPop(out, outSize, len);
+        }
+        bool woken = timeoutMs < 0 ? notEmpty.wait() : notEmpty.waitFor(timeoutMs);
+        header->sleepers.fetch_sub(1, std::memory_order_relaxed);
+        if (tryPop(out, outSize, len)) return true;
+        if (!woken && (timeoutMs >= 0 || notEmpty.isShutdown()))
+            return false;
+    }
+}
+
+void SharedWorkQueue::shutdown() {
+    if (!header) return;
+    header->closed.store(1, std::memory_order_release);
+    notEmpty.shutdown();
+}
+
+bool SharedWorkQueue::isShutdown() const {
+    return header && header->closed.load(std::memory_order_acquire);
+}
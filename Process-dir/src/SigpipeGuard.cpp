@@ -0,0 +1,51 @@
+// This is a demo version of PVS-Studio for educational use.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: https://pvs-studio.com
+#include "../include/SigpipeGuard.h"
+
+#ifdef _WIN32
+
+SigpipeGuard::SigpipeGuard() = default;
+SigpipeGuard::~SigpipeGuard() = default;
+bool SigpipeGuard::active() { return false; }
+
+#else
+
+#include <pthread.h>
+#include <cerrno>
+#include <ctime>
+
+// Guards that blocked SIGPIPE themselves, not those that found it blocked.
+static thread_local unsigned guardsBlocking = 0;
+
+SigpipeGuard::SigpipeGuard() {
+    sigset_t pipeOnly;
+    sigemptyset(&pipeOnly);
+    sigaddset(&pipeOnly, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeOnly, &old);
+    wasBlocked = sigismember(&old, SIGPIPE) == 1;
+    if (!wasBlocked) guardsBlocking++;
+}
+
+bool SigpipeGuard::active() {
+    return guardsBlocking > 0;
+}
+
+SigpipeGuard::~SigpipeGuard() {
+    if (!wasBlocked) {
+        guardsBlocking--;
+        // EPIPE already told the caller; unblocking with the signal still
+        // pending would deliver it now.
+        sigset_t pending;
+        sigemptyset(&pending);
+        if (sigpending(&pending) == 0 && sigismember(&pending, SIGPIPE) == 1) {
+            sigset_t pipeOnly;
+            sigemptyset(&pipeOnly);
+            sigaddset(&pipeOnly, SIGPIPE);
+            timespec zero{};
+            while (sigtimedwait(&pipeOnly, nullptr, &zero) < 0 && errno == EINTR) {}
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &old, nullptr);
+}
+
+#endif
@@ -1,9 +1,11 @@
 // This is a demo version of PVS-Studio for educational use.
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: https://pvs-studio.com
 #include "../include/SocketChannel.h"
+#include "../include/Tracing.h"
 #include <stdexcept>
 #include <iostream>
 #include <cstdio>
+#include <vector>
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -36,10 +38,41 @@ void SocketChannel::ensureWSAStarted() {
 #include <sys/select.h>
 #include <sys/time.h>
 
+#include <fcntl.h>
+
 static inline int to_native(socket_handle h) { return static_cast<int>(h); }
 static inline socket_handle from_native(int s) { return static_cast<socket_handle>(s); }
 static constexpr socket_handle INVALID_SOCKET_HANDLE = -1;
+
+// Library sockets are close-on-exec; children get them only on purpose.
+static int cloexec_socket(int domain, int type, int protocol) {
+#ifdef SOCK_CLOEXEC
+    return ::socket(domain, type | SOCK_CLOEXEC, protocol);
+#else
+    int s = ::socket(domain, type, protocol);
+    if (s != -1) fcntl(s, F_SETFD, FD_CLOEXEC);
+    return s;
+#endif
+}
+
+static int cloexec_accept(int listener) {
+#ifdef __linux__
+    return ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+#else
+    int s = ::accept(listener, nullptr, nullptr);
+    if (s != -1) fcntl(s, F_SETFD, FD_CLOEXEC);
+    return s;
 #endif
+}
+#endif
+
+static bool would_block() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
 
 static std::string make_unix_path(unsigned short port) {
 #ifdef _WIN32
@@ -77,7 +110,7 @@ bool SocketChannel::create(SocketType type) {
         if (s == INVALID_SOCKET) return false;
         sock = from_native(s);
 #else
-        int s = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        int s = cloexec_socket(AF_UNIX, SOCK_STREAM, 0);
         if (s == -1) return false;
         sock = from_native(s);
 #endif
@@ -88,7 +121,7 @@ bool SocketChannel::create(SocketType type) {
         sock = from_native(s);
         
 #else
-        int s = ::socket(AF_INET, SOCK_STREAM, 0);
+        int s = cloexec_socket(AF_INET, SOCK_STREAM, 0);
         if (s == -1) return false;
         sock = from_native(s);
         int opt = 1;
@@ -137,6 +170,7 @@ SocketChannel SocketChannel::acceptClient() {
     SocketChannel c;
     c.sockType = sockType;
     if (sock == INVALID_SOCKET_HANDLE) return c;
+    PROCESS_TRACE1(accept__entry, to_native(sock));
 
     fd_set readfds;
     FD_ZERO(&readfds);
@@ -152,6 +186,7 @@ SocketChannel SocketChannel::acceptClient() {
 #endif
     if (ret <= 0) {
         std::cerr << "[parent] accept timed out\n";
+        PROCESS_TRACE1(accept__return, -1);
         return c;
     }
 
@@ -160,7 +195,8 @@ SocketChannel SocketChannel::acceptClient() {
     if (s == INVALID_SOCKET) return c;
     c.sock = from_native(s);
 #else
-    int s = ::accept(to_native(sock), nullptr, nullptr);
+    int s = cloexec_accept(to_native(sock));
+    PROCESS_TRACE1(accept__return, s);
     if (s == -1) return c;
     c.sock = from_native(s);
 #endif
@@ -214,12 +250,35 @@ std::string SocketChannel::readAll() {
 #else
         ssize_t n = ::recv(to_native(sock), buf, sizeof(buf), 0);
 #endif
+        channelCounters.syscall();
+        if (n < 0 && would_block()) channelCounters.blocked();
         if (n <= 0) break;
         result.append(buf, static_cast<std::size_t>(n));
     }
+    channelCounters.read(result.size());
     return result;
 }
 
+std::uint64_t SocketChannel::readAllTo(OutputSpool& spool) {
+    std::uint64_t got = 0;
+    if (sock == INVALID_SOCKET_HANDLE) return 0;
+    std::vector<char> buf(65536);
+    for (;;) {
+#ifdef _WIN32
+        int n = ::recv(to_native(sock), buf.data(), static_cast<int>(buf.size()), 0);
+#else
+        ssize_t n = ::recv(to_native(sock), buf.data(), buf.size(), 0);
+#endif
+        channelCounters.syscall();
+        if (n < 0 && would_block()) channelCounters.blocked();
+        if (n <= 0) break;
+        spool.append(buf.data(), static_cast<std::size_t>(n));
+        got += static_cast<std::uint64_t>(n);
+    }
+    channelCounters.read(got);
+    return got;
+}
+
 void SocketChannel::write(const std::string& data) {
     if (sock == INVALID_SOCKET_HANDLE) return;
     const char* p = data.data();
@@ -230,8 +289,81 @@ void SocketChannel::write(const std::string& data) {
 #else
         ssize_t n = ::send(to_native(sock), p, left, 0);
 #endif
+        channelCounters.syscall();
+        if (n < 0 && would_block()) channelCounters.blocked();
         if (n <= 0) break;
+        if (static_cast<std::size_t>(n) < left) channelCounters.shortWrite();
         left -= static_cast<std::size_t>(n);
         p += n;
     }
-}
\ No newline at end of file
+    channelCounters.wrote(data.size() - left);
+}
+
+void SocketChannel::writeMany(std::span<const std::string_view> records) {
+    if (sock == INVALID_SOCKET_HANDLE) return;
+#ifdef _WIN32
+    // A blocking WSASend either queues every buffer or fails.
+    std::vector<WSABUF> bufs;
+    bufs.reserve(records.size());
+    for (auto r : records) {
+        if (r.empty()) continue;
+        bufs.push_back({ static_cast<ULONG>(r.size()), const_cast<char*>(r.data()) });
+    }
+    if (bufs.empty()) return;
+    DWORD sent = 0;
+    if (::WSASend(to_native(sock), bufs.data(), static_cast<DWORD>(bufs.size()), &sent, 0, nullptr, nullptr) != 0 &&
+        would_block())
+        channelCounters.blocked();
+    channelCounters.syscall();
+    channelCounters.wrote(sent);
+#else
+    write_records(to_native(sock), records, channelCounters);
+#endif
+}
+
+bool SocketChannel::writeBytes(const void* data, std::size_t len) {
+    if (sock == INVALID_SOCKET_HANDLE) return false;
+    const char* p = static_cast<const char*>(data);
+    std::size_t left = len;
+    while (left > 0) {
+#ifdef _WIN32
+        int chunk = static_cast<int>(left > (1u << 30) ? (1u << 30) : left);
+        int n = ::send(to_native(sock), p, chunk, 0);
+#else
+        ssize_t n = ::send(to_native(sock), p, left, 0);
+        if (n < 0 && errno == EINTR) continue;
+#endif
+        channelCounters.syscall();
+        if (n < 0 && would_block()) channelCounters.blocked();
+        if (n <= 0) break;
+        if (static_cast<std::size_t>(n) < left) channelCounters.shortWrite();
+        left -= static_cast<std::size_t>(n);
+        p += n;
+    }
+    channelCounters.wrote(len - left);
+    return left == 0;
+}
+
+bool SocketChannel::readExact(void* out, std::size_t len, std::size_t* received) {
+    if (received) *received = 0;
+    if (sock == INVALID_SOCKET_HANDLE) return false;
+    char* p = static_cast<char*>(out);
+    std::size_t left = len;
+    while (left > 0) {
+#ifdef _WIN32
+        int chunk = static_cast<int>(left > (1u << 30) ? (1u << 30) : left);
+        int n = ::recv(to_native(sock), p, chunk, 0);
+#else
+        ssize_t n = ::recv(to_native(sock), p, left, 0);
+        if (n < 0 && errno == EINTR) continue;
+#endif
+        channelCounters.syscall();
+        if (n < 0 && would_block()) channelCounters.blocked();
+        if (n <= 0) break;
+        left -= static_cast<std::size_t>(n);
+        p += n;
+    }
+    channelCounters.read(len - left);
+    if (received) *received = len - left;
+    return left == 0;
+}
@@ -0,0 +1,167 @@
+// This is a demo version of PVS-Studio for educational use.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: https://pvs-studio.com
+#include "../include/SpawnArena.h"
+#include <cstdlib>
+#include <climits>
+#include <fstream>
+#include <sstream>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#endif
+#endif
+
+#ifndef _WIN32
+// execvp() is not async-signal-safe, so the PATH lookup happens here, once.
+static std::string resolve_path(const std::string& exe) {
+    if (exe.empty() || exe.find('/') != std::string::npos) return exe;
+
+    const char* env = std::getenv("PATH");
+    std::stringstream dirs(env ? env : "/usr/local/bin:/usr/bin:/bin");
+    std::string dir;
+    while (std::getline(dirs, dir, ':')) {
+        std::string candidate = (dir.empty() ? "." : dir) + "/" + exe;
+        struct stat st;
+        if (::stat(candidate.c_str(), &st) == 0 && S_ISREG(st.st_mode) && ::access(candidate.c_str(), X_OK) == 0)
+            return candidate;
+    }
+    return exe;  // exec fails with ENOENT, as execvp would
+}
+
+static void set_bit(std::vector<unsigned long>& mask, int bit) {
+    const int perWord = 8 * sizeof(unsigned long);
+    if (bit < 0) return;
+    if (mask.size() <= static_cast<size_t>(bit / perWord))
+        mask.resize(bit / perWord + 1, 0);
+    mask[bit / perWord] |= 1UL << (bit % perWord);
+}
+
+// Parses a sysfs cpulist such as "0-3,8-11".
+static std::vector<int> read_cpulist(const std::string& path) {
+    std::vector<int> cpus;
+    std::ifstream in(path);
+    std::string list;
+    if (!std::getline(in, list)) return cpus;
+
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty()) continue;
+        size_t dash = range.find('-');
+        int lo = std::stoi(range.substr(0, dash));
+        int hi = dash == std::string::npos ? lo : std::stoi(range.substr(dash + 1));
+        for (int c = lo; c <= hi; c++) cpus.push_back(c);
+    }
+    return cpus;
+}
+#endif
+
+SpawnArena::SpawnArena(const std::string& executable, const std::vector<std::string>& args,
+                       const SpawnOptions& options) {
+    size_t total = executable.size() + 1 + options.workingDirectory.size() + 1;
+    for (auto& a : args) total += a.size() + 1;
+    if (options.environment)
+        for (auto& e : *options.environment) total += e.size() + 1;
+    storage.reserve(total + 256);
+
+#ifdef _WIN32
+    pathOffset = append(executable);
+#else
+    pathOffset = append(resolve_path(executable));
+#endif
+    argOffsets.push_back(append(executable));  // argv[0] as the caller wrote it
+    for (auto& a : args)
+        argOffsets.push_back(append(a));
+
+    if (!options.workingDirectory.empty()) {
+        cwdOffset = append(options.workingDirectory);
+        hasCwd = true;
+    }
+
+    std::vector<size_t> envOffsets;
+    if (options.environment)
+        for (auto& e : *options.environment)
+            envOffsets.push_back(append(e));
+
+    // storage is final from here on; pointers into it stay valid.
+    if (options.environment) {
+        for (size_t off : envOffsets)
+            envTable.push_back(storage.data() + off);
+        envTable.push_back(nullptr);
+    }
+
+#ifndef _WIN32
+    std::vector<int> cpus = options.cpus;
+    if (options.numaNode >= 0) {
+        set_bit(nodeMask, options.numaNode);
+        if (cpus.empty())
+            cpus = read_cpulist("/sys/devices/system/node/node" + std::to_string(options.numaNode) + "/cpulist");
+    }
+    for (int cpu : cpus) set_bit(cpuMask, cpu);
+
+    long maxFd = sysconf(_SC_OPEN_MAX);
+    fdLimit = maxFd > 0 && maxFd < INT_MAX ? static_cast<int>(maxFd) : 65536;
+#endif
+}
+
+size_t SpawnArena::append(const std::string& s) {
+    size_t off = storage.size();
+    storage.insert(storage.end(), s.begin(), s.end());
+    storage.push_back('\0');
+    return off;
+}
+
+void SpawnArena::buildArgv(const std::vector<std::string>& prefix, std::vector<char*>& table) const {
+    char* base = const_cast<char*>(storage.data());
+    table.clear();
+    table.push_back(base + argOffsets[0]);
+    for (auto& p : prefix)
+        table.push_back(const_cast<char*>(p.c_str()));
+    for (size_t i = 1; i < argOffsets.size(); i++)
+        table.push_back(base + argOffsets[i]);
+    table.push_back(nullptr);
+}
+
+#ifndef _WIN32
+void SpawnArena::applyPlacement() const {
+#ifdef __linux__
+    if (!cpuMask.empty())
+        syscall(SYS_sched_setaffinity, 0, cpuMask.size() * sizeof(unsigned long), cpuMask.data());
+#ifdef SYS_set_mempolicy
+    if (!nodeMask.empty())
+        syscall(SYS_set_mempolicy, MPOL_PREFERRED, nodeMask.data(), nodeMask.size() * 8 * sizeof(unsigned long));
+#endif
+#endif
+}
+
+// Closes [lo, hi] in one close_range call where available.
+static void close_fd_range(int lo, int hi, int limit) {
+    if (lo > hi) return;
+#ifdef SYS_close_range
+    if (syscall(SYS_close_range, static_cast<unsigned>(lo), static_cast<unsigned>(hi), 0) == 0)
+        return;
+#endif
+    for (int fd = lo; fd <= hi && fd < limit; fd++)
+        ::close(fd);
+}
+
+// Every library descriptor is close-on-exec, but anything else the parent
+// opened (or other children's pipe ends) would leak, so all fds above
+// stderr that are not explicitly kept are closed.
+void SpawnArena::closeFdsExcept(const int* keep, size_t count) const {
+    int from = STDERR_FILENO + 1;
+    for (size_t i = 0; i < count; i++) {
+        int fd = keep[i];
+        if (fd < from) continue;
+        fcntl(fd, F_SETFD, 0);
+        close_fd_range(from, fd - 1, fdLimit);
+        from = fd + 1;
+    }
+    close_fd_range(from, INT_MAX, fdLimit);
+}
+#endif
@@ -0,0 +1,448 @@
+// This is a demo version of PVS-Studio for educational use.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: https://pvs-studio.com
+#include "../include/SpawnServer.h"
+#include "../include/SpawnArena.h"
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+
+#ifdef _WIN32
+
+SpawnServer::SpawnServer() = default;
+SpawnServer::~SpawnServer() = default;
+
+bool SpawnServer::start() {
+    return false;
+}
+
+bool SpawnServer::startTemplate(const std::string&, const std::vector<std::string>&, const SpawnOptions&) {
+    return false;
+}
+
+bool SpawnServer::isTemplate(int, char**) {
+    return false;
+}
+
+void SpawnServer::serveTemplate(int, char**, const WorkerMain&) {
+    std::exit(1);
+}
+
+#else
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <cerrno>
+#include <climits>
+#include <algorithm>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+extern char** environ;
+
+namespace {
+
+constexpr size_t maxMessage = 128 * 1024;
+constexpr size_t maxFds = 64;
+constexpr const char* templateFlag = "--spawn-template";
+
+// Requests and replies are flat byte strings: 32-bit integers and
+// length-prefixed strings, written and read in the same order.
+struct Encoder {
+    std::string out;
+    void u32(std::uint32_t v) { out.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+    void i32(std::int32_t v) { out.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+    void str(const std::string& s) { u32(static_cast<std::uint32_t>(s.size())); out += s; }
+    void raw(const void* p, size_t n) { out.append(static_cast<const char*>(p), n); }
+};
+
+struct Decoder {
+    const char* p;
+    const char* end;
+    bool ok = true;
+    bool take(void* dst, size_t n) {
+        if (!ok || static_cast<size_t>(end - p) < n) return ok = false;
+        std::memcpy(dst, p, n);
+        p += n;
+        return true;
+    }
+    std::uint32_t u32() { std::uint32_t v = 0; take(&v, sizeof(v)); return v; }
+    std::int32_t i32() { std::int32_t v = 0; take(&v, sizeof(v)); return v; }
+    std::string str() {
+        std::uint32_t n = u32();
+        if (!ok || static_cast<size_t>(end - p) < n) { ok = false; return {}; }
+        std::string s(p, n);
+        p += n;
+        return s;
+    }
+};
+
+// Sends one message with up to maxFds descriptors attached.
+bool send_message(int fd, const std::string& data, const int* fds, size_t count) {
+    iovec iov{ const_cast<char*>(data.data()), data.size() };
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * maxFds)];
+    if (count > 0) {
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+        cmsghdr* c = CMSG_FIRSTHDR(&msg);
+        c->cmsg_level = SOL_SOCKET;
+        c->cmsg_type = SCM_RIGHTS;
+        c->cmsg_len = CMSG_LEN(sizeof(int) * count);
+        std::memcpy(CMSG_DATA(c), fds, sizeof(int) * count);
+    }
+
+    ssize_t n;
+    do {
+        n = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    return n == static_cast<ssize_t>(data.size());
+}
+
+// Receives one message; attached descriptors arrive close-on-exec.
+// Returns false on EOF or error.
+bool recv_message(int fd, std::string& data, std::vector<int>& fds) {
+    data.resize(maxMessage);
+    iovec iov{ data.data(), data.size() };
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * maxFds)];
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t n;
+    do {
+        n = ::recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) return false;
+    data.resize(static_cast<size_t>(n));
+
+    fds.clear();
+    for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+        if (c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_RIGHTS) continue;
+        size_t k = (c->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        const unsigned char* d = CMSG_DATA(c);
+        for (size_t i = 0; i < k; i++) {
+            int received;
+            std::memcpy(&received, d + i * sizeof(int), sizeof(int));
+            fds.push_back(received);
+        }
+    }
+    return true;
+}
+
+[[noreturn]] void exec_fail(const char* what, const char* detail) {
+    ssize_t ignored = ::write(STDERR_FILENO, what, std::strlen(what));
+    ignored = ::write(STDERR_FILENO, detail, std::strlen(detail));
+    ignored = ::write(STDERR_FILENO, "\n", 1);
+    (void)ignored;
+    _exit(127);
+}
+
+int open_pidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    return -1;
+#endif
+}
+
+}
+
+SpawnServer::SpawnServer() = default;
+
+SpawnServer::~SpawnServer() {
+    if (sock != -1) ::close(sock);
+    if (server > 0) {
+        int raw;
+        while (waitpid(server, &raw, 0) < 0 && errno == EINTR) {}
+    }
+}
+
+bool SpawnServer::start() {
+    if (sock != -1) return true;
+
+    int pair[2];
+    if (::socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, pair) != 0)
+        return false;
+
+    server = fork();
+    if (server < 0) {
+        ::close(pair[0]);
+        ::close(pair[1]);
+        return false;
+    }
+    if (server == 0) {
+        ::close(pair[0]);
+        serve(pair[1], nullptr);
+    }
+    ::close(pair[1]);
+    sock = pair[0];
+    return true;
+}
+
+// Server main loop. It is a plain single-threaded process, so unlike a fork
+// from the parent it may allocate between its own fork and exec.
+void SpawnServer::serve(int fd, const WorkerMain* workerMain) {
+    std::string msg;
+    std::vector<int> fds;
+    std::vector<char*> argv;
+
+    while (recv_message(fd, msg, fds)) {
+        Decoder in{ msg.data(), msg.data() + msg.size() };
+        Encoder out;
+        char kind = 0;
+        in.take(&kind, 1);
+
+        if (kind == 'S') {
+            std::string path = in.str();
+            std::vector<std::string> args(in.u32());
+            for (auto& a : args) a = in.str();
+
+            SpawnOptions opts;
+            if (in.u32()) {
+                opts.environment.emplace(in.u32());
+                for (auto& e : *opts.environment) e = in.str();
+            }
+            opts.workingDirectory = in.str();
+            opts.cpus.resize(in.u32());
+            for (int& c : opts.cpus) c = in.i32();
+            opts.numaNode = in.i32();
+
+            std::vector<int> targets(in.u32());
+            for (int& t : targets) t = in.i32();
+
+            pid_t child = -1;
+            int err = EINVAL;
+            if (in.ok && targets.size() == fds.size()) {
+                SpawnArena arena(path, args, opts);
+                arena.buildArgv({}, argv);
+                std::vector<int> keep(targets);
+                std::sort(keep.begin(), keep.end());
+                int top = keep.empty() ? STDERR_FILENO : std::max(keep.back(), static_cast<int>(STDERR_FILENO));
+
+                // A template's buffered output would otherwise be written
+                // again by every worker.
+                if (workerMain) {
+                    std::cout.flush();
+                    std::fflush(nullptr);
+                }
+
+                child = fork();
+                if (child == 0) {
+                    // Lift every source above the highest target first, so
+                    // no dup2 clobbers a source still waiting to be moved.
+                    for (int& f : fds)
+                        f = fcntl(f, F_DUPFD_CLOEXEC, top + 1);
+                    for (size_t i = 0; i < fds.size(); i++)
+                        dup2(fds[i], targets[i]);
+
+                    arena.applyPlacement();
+                    arena.closeFdsExcept(keep.data(), keep.size());
+                    if (const char* cwd = arena.workingDirectory())
+                        if (chdir(cwd) != 0)
+                            exec_fail("chdir failed: ", cwd);
+                    if (workerMain) {
+                        // A forked worker, not an exec: the template is
+                        // single-threaded, so the child may use libc freely.
+                        if (opts.environment) {
+                            clearenv();
+                            for (auto& e : *opts.environment) putenv(e.data());
+                        }
+                        int code = (*workerMain)(static_cast<int>(argv.size() - 1), argv.data());
+                        std::cout.flush();
+                        std::fflush(nullptr);
+                        _exit(code);
+                    }
+                    char* const* envp = arena.envp();
+                    execve(arena.path(), argv.data(), envp ? envp : environ);
+                    exec_fail("execve failed: ", arena.path());
+                }
+                err = child < 0 ? errno : 0;
+            }
+            for (int f : fds) ::close(f);
+
+            out.i32(child);
+            out.i32(err);
+            int pidfd = child > 0 ? open_pidfd(child) : -1;
+            send_message(fd, out.out, &pidfd, pidfd != -1 ? 1 : 0);
+            if (pidfd != -1) ::close(pidfd);
+        } else if (kind == 'W') {
+            pid_t pid = in.i32();
+            int raw = 0;
+            struct rusage ru{};
+            pid_t r;
+            do {
+                r = wait4(pid, &raw, WNOHANG, &ru);
+            } while (r < 0 && errno == EINTR);
+            out.i32(r);
+            out.i32(raw);
+            out.raw(&ru, sizeof(ru));
+            send_message(fd, out.out, nullptr, 0);
+        } else {
+            for (int f : fds) ::close(f);
+            send_message(fd, out.out, nullptr, 0);
+        }
+    }
+    _exit(0);
+}
+
+// Template launch: like Process, everything the child needs is prepared
+// before fork, and it only makes raw syscalls until execve.
+bool SpawnServer::startTemplate(const std::string& path, const std::vector<std::string>& args,
+                                const SpawnOptions& options) {
+    if (sock != -1) return false;
+
+    int pair[2];
+    if (::socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, pair) != 0)
+        return false;
+
+    // buildArgv points into 'prefix', so it must outlive the exec.
+    SpawnArena arena(path, args, options);
+    std::vector<std::string> prefix{ templateFlag, std::to_string(pair[1]) };
+    std::vector<char*> argv;
+    arena.buildArgv(prefix, argv);
+
+    server = fork();
+    if (server < 0) {
+        ::close(pair[0]);
+        ::close(pair[1]);
+        return false;
+    }
+    if (server == 0) {
+        arena.applyPlacement();
+        arena.closeFdsExcept(&pair[1], 1);
+        if (const char* cwd = arena.workingDirectory())
+            if (chdir(cwd) != 0)
+                exec_fail("chdir failed: ", cwd);
+        char* const* envp = arena.envp();
+        execve(arena.path(), argv.data(), envp ? envp : environ);
+        exec_fail("execve failed: ", arena.path());
+    }
+    ::close(pair[1]);
+    sock = pair[0];
+
+    // The template says 'R' once it is warm; EOF means it died first.
+    std::string ready;
+    std::vector<int> fds;
+    if (!recv_message(sock, ready, fds) || ready != "R") {
+        for (int f : fds) ::close(f);
+        ::close(sock);
+        sock = -1;
+        int raw;
+        while (waitpid(server, &raw, 0) < 0 && errno == EINTR) {}
+        server = -1;
+        return false;
+    }
+    return true;
+}
+
+bool SpawnServer::isTemplate(int argc, char** argv) {
+    return argc >= 3 && std::strcmp(argv[1], templateFlag) == 0;
+}
+
+void SpawnServer::serveTemplate(int argc, char** argv, const WorkerMain& workerMain) {
+    if (!isTemplate(argc, argv)) {
+        std::cerr << "SpawnServer::serveTemplate: not started by startTemplate()\n";
+        std::exit(2);
+    }
+    int fd = std::atoi(argv[2]);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    if (!send_message(fd, "R", nullptr, 0))
+        _exit(1);
+    serve(fd, &workerMain);
+}
+
+void SpawnServer::call(const std::string& request, const int* fds, size_t count,
+                       std::string& reply, int* receivedFd) {
+    if (sock == -1)
+        throw std::runtime_error("SpawnServer is not running");
+    if (count > maxFds)
+        throw std::runtime_error("SpawnServer: too many descriptors for one spawn");
+    if (request.size() > maxMessage)
+        throw std::runtime_error("SpawnServer: spawn request too large");
+
+    std::lock_guard<std::mutex> guard(lock);
+    std::vector<int> got;
+    if (!send_message(sock, request, fds, count) || !recv_message(sock, reply, got))
+        throw std::runtime_error("SpawnServer: lost connection to the server");
+
+    if (receivedFd)
+        *receivedFd = got.empty() ? -1 : got[0];
+    for (size_t i = receivedFd ? 1 : 0; i < got.size(); i++)
+        ::close(got[i]);
+}
+
+pid_t SpawnServer::spawn(const std::string& path, char* const* argv, const SpawnOptions& options,
+                         const int* fds, const int* targets, size_t count, int& pidFD) {
+    Encoder req;
+    req.raw("S", 1);
+    req.str(path);
+    std::uint32_t argc = 0;
+    while (argv && argv[argc]) argc++;
+    req.u32(argc > 0 ? argc - 1 : 0);
+    for (std::uint32_t i = 1; i < argc; i++) req.str(argv[i]);
+
+    req.u32(options.environment ? 1 : 0);
+    if (options.environment) {
+        req.u32(static_cast<std::uint32_t>(options.environment->size()));
+        for (auto& e : *options.environment) req.str(e);
+    }
+    req.str(options.workingDirectory);
+    req.u32(static_cast<std::uint32_t>(options.cpus.size()));
+    for (int c : options.cpus) req.i32(c);
+    req.i32(options.numaNode);
+    req.u32(static_cast<std::uint32_t>(count));
+    for (size_t i = 0; i < count; i++) req.i32(targets[i]);
+
+    std::string reply;
+    pidFD = -1;
+    call(req.out, fds, count, reply, &pidFD);
+
+    Decoder in{ reply.data(), reply.data() + reply.size() };
+    pid_t pid = in.i32();
+    int err = in.i32();
+    if (!in.ok || pid <= 0) {
+        if (pidFD != -1) ::close(pidFD);
+        pidFD = -1;
+        throw std::runtime_error("SpawnServer: spawn of " + path + " failed: " + std::strerror(err));
+    }
+    return pid;
+}
+
+pid_t SpawnServer::wait(pid_t pid, int pidFD, bool block, int& rawStatus, struct rusage& usage) {
+    Encoder req;
+    req.raw("W", 1);
+    req.i32(pid);
+
+    for (;;) {
+        std::string reply;
+        call(req.out, nullptr, 0, reply, nullptr);
+        Decoder in{ reply.data(), reply.data() + reply.size() };
+        pid_t r = in.i32();
+        rawStatus = in.i32();
+        in.take(&usage, sizeof(usage));
+        if (!in.ok)
+            throw std::runtime_error("SpawnServer: malformed wait reply");
+        if (r != 0 || !block) return r;
+
+        // Still running: sleep until it exits rather than asking again.
+        if (pidFD != -1) {
+            pollfd p{ pidFD, POLLIN, 0 };
+            while (::poll(&p, 1, -1) < 0 && errno == EINTR) {}
+        } else {
+            ::usleep(1000);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,250 @@
+// This is a demo version of PVS-Studio for educational use.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: https://pvs-studio.com
+#include "../include/WorkerPool.h"
+#include "../include/SigpipeGuard.h"
+#include <stdexcept>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <cerrno>
+#endif
+
+WorkerPool::WorkerPool(const std::string& path, const std::vector<std::string>& args,
+                       size_t count, const SpawnOptions& opts)
+    : executable(path), arguments(args), options(opts), workers(count) {
+    if (count == 0)
+        throw std::runtime_error("WorkerPool needs at least one worker");
+}
+
+WorkerPool::~WorkerPool() {
+    shutdown();
+}
+
+void WorkerPool::start() {
+    Process prototype(executable, arguments, options);
+    std::vector<std::unique_ptr<Process>> procs = Process::spawnMany(workers.size(), prototype);
+    for (size_t i = 0; i < workers.size(); i++) {
+        Worker& w = workers[i];
+        w.proc = std::move(procs[i]);
+#ifndef _WIN32
+        w.proc->stdinStream().setNonBlocking(true);
+        w.proc->stdoutStream().setNonBlocking(true);
+        w.proc->stderrStream().setNonBlocking(true);
+#endif
+        w.alive = true;
+    }
+}
+
+WorkerPool::TaskId WorkerPool::submit(std::string task, size_t worker) {
+    if (task.find('\n') != std::string::npos)
+        throw std::runtime_error("WorkerPool tasks are single lines");
+    if (worker == anyWorker) {
+        worker = nextWorker;
+        nextWorker = (nextWorker + 1) % workers.size();
+    }
+
+    TaskId id = tasks.size();
+    tasks.push_back(std::move(task));
+    results.emplace_back();
+    workers.at(worker).queue.push_back(id);
+    pending++;
+    return id;
+}
+
+WorkerPool::WorkerStats WorkerPool::stats(size_t worker) const {
+    const Worker& w = workers.at(worker);
+    WorkerStats s;
+    s.completed = w.completed;
+    s.stolen = w.stolen;
+    s.queued = w.queue.size();
+    s.inFlight = w.inFlight.size();
+    s.unsolicited = w.unsolicited;
+    s.alive = w.alive;
+    s.busy = w.busy;
+    return s;
+}
+
+// Tops worker w up to 'depth' tasks in flight: its own deque first, then
+// the back of the fullest other deque. Returns true if anything was sent.
+bool WorkerPool::refill(size_t w) {
+    Worker& me = workers[w];
+    bool sent = false;
+    while (me.alive && me.inFlight.size() < depth) {
+        TaskId id;
+        if (!me.queue.empty()) {
+            id = me.queue.front();
+            me.queue.pop_front();
+        } else {
+            auto victim = std::max_element(workers.begin(), workers.end(),
+                [](const Worker& a, const Worker& b) { return a.queue.size() < b.queue.size(); });
+            if (victim->queue.empty()) break;
+            id = victim->queue.back();
+            victim->queue.pop_back();
+            me.stolen++;
+        }
+
+        if (me.inFlight.empty()) me.busySince = Clock::now();
+        me.inFlight.push_back(id);
+        results[id].attempts++;
+        me.outbound += tasks[id];
+        me.outbound += '\n';
+        sent = true;
+    }
+    return sent;
+}
+
+void WorkerPool::finish(TaskId id, size_t w, bool ok, std::string reply) {
+    TaskResult& r = results[id];
+    r.done = true;
+    r.ok = ok;
+    r.reply = std::move(reply);
+    r.worker = w;
+    pending--;
+    if (completion) completion(id, r);
+}
+
+void WorkerPool::workerDied(size_t w) {
+    Worker& me = workers[w];
+    if (!me.alive) return;
+    me.alive = false;
+    if (!me.inFlight.empty()) me.busy += Clock::now() - me.busySince;
+    me.outbound.clear();
+
+    // Retry what it was running on the survivors; its deque stays put and
+    // is drained by stealing.
+    bool anyAlive = std::any_of(workers.begin(), workers.end(), [](const Worker& x) { return x.alive; });
+    for (TaskId id : me.inFlight) {
+        if (results[id].attempts < maxAttempts && anyAlive)
+            me.queue.push_front(id);
+        else
+            finish(id, w, false, {});
+    }
+    me.inFlight.clear();
+
+    if (!anyAlive) {
+        for (auto& x : workers) {
+            for (TaskId id : x.queue) finish(id, w, false, {});
+            x.queue.clear();
+        }
+    }
+}
+
+#ifdef _WIN32
+
+void WorkerPool::run() {
+    throw std::runtime_error("WorkerPool::run requires poll(); not supported on Windows");
+}
+
+#else
+
+void WorkerPool::run() {
+    if (workers.front().proc == nullptr)
+        start();
+
+    // A worker that died mid-task must cost a retry, not the parent.
+    SigpipeGuard sigpipeGuard;
+    std::vector<pollfd> fds;
+    enum class Slot { Stdin, Stdout, Stderr };
+    std::vector<std::pair<size_t, Slot>> owners;
+
+    while (pending > 0) {
+        for (size_t w = 0; w < workers.size(); w++)
+            refill(w);
+
+        fds.clear();
+        owners.clear();
+        for (size_t w = 0; w < workers.size(); w++) {
+            Worker& me = workers[w];
+            if (!me.alive) continue;
+            if (!me.outbound.empty()) {
+                fds.push_back({ me.proc->stdinStream().getWriteFD(), POLLOUT, 0 });
+                owners.push_back({ w, Slot::Stdin });
+            }
+            fds.push_back({ me.proc->stdoutStream().getReadFD(), POLLIN, 0 });
+            owners.push_back({ w, Slot::Stdout });
+            if (me.proc->stderrStream().getReadFD() != -1) {
+                fds.push_back({ me.proc->stderrStream().getReadFD(), POLLIN, 0 });
+                owners.push_back({ w, Slot::Stderr });
+            }
+        }
+        if (fds.empty()) {
+            // Every worker is gone; tasks submitted since the last one died
+            // can never run.
+            for (auto& x : workers) {
+                for (TaskId id : x.queue) finish(id, anyWorker, false, {});
+                x.queue.clear();
+            }
+            break;
+        }
+
+        int r = ::poll(fds.data(), fds.size(), -1);
+        if (r < 0 && errno != EINTR)
+            throw std::runtime_error("WorkerPool poll failed");
+
+        for (size_t i = 0; r > 0 && i < fds.size(); i++) {
+            if (!fds[i].revents) continue;
+            size_t w = owners[i].first;
+            Worker& me = workers[w];
+            if (!me.alive) continue;
+
+            switch (owners[i].second) {
+            case Slot::Stdin: {
+                long put = me.proc->stdinStream().writeSome(me.outbound);
+                if (put > 0)
+                    me.outbound.erase(0, static_cast<size_t>(put));
+                else if (put < 0 && errno != EAGAIN)
+                    workerDied(w);
+                break;
+            }
+            case Slot::Stdout: {
+                long got = me.proc->stdoutStream().readSome(me.inbound);
+                if (got == 0 || (got < 0 && errno != EAGAIN)) {
+                    workerDied(w);
+                    break;
+                }
+                size_t start = 0, nl;
+                while ((nl = me.inbound.find('\n', start)) != std::string::npos) {
+                    // A line nobody asked for would otherwise be taken as
+                    // the reply to the next task; keep it with stderr.
+                    if (me.inFlight.empty()) {
+                        me.errors.append(me.inbound, start, nl + 1 - start);
+                        me.unsolicited++;
+                        start = nl + 1;
+                        continue;
+                    }
+                    TaskId id = me.inFlight.front();
+                    me.inFlight.pop_front();
+                    me.completed++;
+                    if (me.inFlight.empty()) me.busy += Clock::now() - me.busySince;
+                    finish(id, w, true, me.inbound.substr(start, nl - start));
+                    start = nl + 1;
+                }
+                me.inbound.erase(0, start);
+                if (me.errors.size() > 65536)
+                    me.errors.erase(0, me.errors.size() - 65536);
+                break;
+            }
+            case Slot::Stderr: {
+                long got = me.proc->stderrStream().readSome(me.errors);
+                if (got == 0 || (got < 0 && errno != EAGAIN))
+                    me.proc->stderrStream().closeRead();
+                if (me.errors.size() > 65536)
+                    me.errors.erase(0, me.errors.size() - 65536);
+                break;
+            }
+            }
+        }
+    }
+}
+
+#endif
+
+void WorkerPool::shutdown() {
+    for (auto& w : workers) {
+        if (!w.proc) continue;
+        w.proc->closeStdin();
+        w.proc->wait();
+        w.alive = false;
+    }
+}
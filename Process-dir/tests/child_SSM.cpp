@@ -2,7 +2,7 @@
 #include <iostream>
 
 int main(int argc, char* argv[]) {
-    if (argc < 4) {
+    if (argc < 6) {
         std::cerr << "ERROR: Shared memory names not provided.\n";
         std::cerr << "argc = " << argc << "\n";
         for (int i = 0; i < argc; i++)
@@ -24,8 +24,8 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    if (!err.open(argv[3], SIZE)) {
-        std::cerr << "ERROR: cannot open SHM ERR: " << argv[3] << "\n";
+    if (!err.open(argv[5], SIZE)) {
+        std::cerr << "ERROR: cannot open SHM ERR: " << argv[5] << "\n";
         return 1;
     }
 
@@ -0,0 +1,44 @@
+#include <string>
+#include <cstdlib>
+#include <thread>
+#include <chrono>
+
+#include "../include/RpcChannel.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Server for test_rpc: a request "<ms> <text>" sleeps that long and replies
+// "<text>"; "crash" exits without answering. Serves over stdio, or with
+// "--queues <requests> <responses>" over two shared work queues.
+static std::string handle(std::string_view request) {
+    if (request == "crash")
+        std::_Exit(3);
+    size_t space = request.find(' ');
+    int ms = std::atoi(std::string(request.substr(0, space)).c_str());
+    if (ms > 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    return space == std::string_view::npos ? std::string() : std::string(request.substr(space + 1));
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 4 && std::string(argv[1]) == "--queues") {
+        SharedWorkQueue requests, responses;
+        if (!requests.open(argv[2], 64, 256) || !responses.open(argv[3], 64, 256))
+            return 2;
+        RpcServer server(responses, requests);
+        server.serve(handle);
+        return 0;
+    }
+
+    Pipe stdio;
+#ifdef _WIN32
+    stdio.adopt(GetStdHandle(STD_INPUT_HANDLE), GetStdHandle(STD_OUTPUT_HANDLE));
+#else
+    stdio.adopt(0, 1);
+#endif
+    RpcServer server(stdio, stdio);
+    server.serve(handle);
+    return 0;
+}
@@ -1,10 +1,11 @@
 #include <iostream>
+#include <memory>
 #include "../include/SharedMemoryChannel.h"
 #include "../include/SharedSemaphore.h"
 
 int main(int argc, char** argv) {
     if (argc < 5) {
-        std::cerr << "Expected shmIn shmOut semIn semOut\n";
+        std::cerr << "Expected shmIn shmOut semIn semOut [shmErr semErr]\n";
         return 1;
     }
 
@@ -20,14 +21,30 @@ int main(int argc, char** argv) {
     SharedSemaphore semIn(semInName,  false);
     SharedSemaphore semOut(semOutName, false);
 
-    while (true) {
-        semIn.wait();
+    // Optional stderr stream, passed by parents that provide one.
+    SharedMemoryChannel shmErr;
+    std::unique_ptr<SharedSemaphore> semErr;
+    if (argc >= 7) {
+        shmErr.open(argv[5], 4096);
+        semErr = std::make_unique<SharedSemaphore>(argv[6], false);
+    }
+
+    int handled = 0;
+    while (semIn.wait()) {
         std::string msg = shmIn.read();
         if (msg == "exit") break;
 
         shmOut.write("child: " + msg);
         semOut.post();
+        handled++;
+    }
+
+    if (semErr) {
+        shmErr.write("child handled " + std::to_string(handled));
+        semErr->post();
+        semErr->shutdown();
     }
+    semOut.shutdown();
 
     return 0;
-}
\ No newline at end of file
+}
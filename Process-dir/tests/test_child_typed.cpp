@@ -0,0 +1,33 @@
+#include <cstdint>
+
+#include "../include/TypedChannel.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Child for test_typed_channel: reads Sample records from stdin and echoes
+// each one to stdout with its value doubled. Must match the parent's Sample.
+struct Sample {
+    std::uint32_t id;
+    std::uint32_t flags;
+    double value;
+    char name[16];
+};
+
+int main() {
+    Pipe stdio;
+#ifdef _WIN32
+    stdio.adopt(GetStdHandle(STD_INPUT_HANDLE), GetStdHandle(STD_OUTPUT_HANDLE));
+#else
+    stdio.adopt(0, 1);
+#endif
+    TypedChannel<Sample> in(stdio), out(stdio);
+
+    Sample s;
+    while (in.receive(s)) {
+        s.value *= 2;
+        if (!out.send(s)) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,32 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <chrono>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+// Worker for test_worker_pool: each stdin line is a task. "crash" exits,
+// "stray" replies, then prints an extra line 100 ms later; anything else is
+// a number of milliseconds to sleep. Replies "<task> <pid>".
+int main() {
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (line == "crash")
+            return 3;
+        if (line == "stray") {
+            std::cout << line << " " << getpid() << std::endl;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            std::cout << "not a reply" << std::endl;
+            continue;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(std::stoi(line)));
+        std::cout << line << " " << getpid() << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+
+#include "../include/SpawnServer.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+// Template/worker for test_zygote. Initialization is deliberately slow (a
+// 300 ms stall plus a 32 MiB table). Each stdin line is answered with
+// "<table checksum> <pid> <times initialized in this image> <argv[1]>".
+static std::vector<std::uint64_t> table;
+static int initializations = 0;
+
+static void warm_up() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    table.resize((32u << 20) / sizeof(std::uint64_t));
+    for (size_t i = 0; i < table.size(); i++)
+        table[i] = i * 2654435761u;
+    initializations++;
+}
+
+static int worker_main(int argc, char** argv) {
+    std::uint64_t sum = 0;
+    for (size_t i = 0; i < table.size(); i += 4096)
+        sum += table[i];
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::cout << sum << " " << getpid() << " " << initializations << " "
+                  << (argc > 1 ? argv[1] : "-") << std::endl;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+#ifndef _WIN32
+    if (SpawnServer::isTemplate(argc, argv)) {
+        warm_up();
+        SpawnServer::serveTemplate(argc, argv, worker_main);
+    }
+#endif
+    warm_up();
+    return worker_main(argc, argv);
+}
@@ -0,0 +1,220 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <csignal>
+
+#include "../include/JobGraph.h"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+
+using Clock = std::chrono::steady_clock;
+
+void test_streamed_edges() {
+    std::cout << "\n===== TEST 1: data flows along edges, fan-out and fan-in =====\n";
+
+    JobGraph g;
+    auto gen   = g.add("gen",   "seq",  {"1", "300000"});
+    auto ones  = g.add("ones",  "grep", {"1$"});
+    auto twos  = g.add("twos",  "grep", {"2$"});
+    auto merge = g.add("merge", "wc",   {"-l"});
+    g.pipe(gen, ones);
+    g.pipe(gen, twos);
+    g.pipe(ones, merge);
+    g.pipe(twos, merge);
+    g.keepStdout(gen);
+
+    bool ok = g.run();
+    std::cout << g.report();
+    assert(ok);
+
+    // 300000 numbers, a tenth end in 1 and a tenth in 2.
+    assert(std::stoi(g.result(merge).stdoutData) == 60000);
+    assert(g.result(gen).stdoutData.size() > 1'000'000);
+    assert(g.result(gen).stdoutBytes == g.result(gen).stdoutData.size());
+    // Without keepStdout() what merge was fed is released.
+    assert(g.result(ones).stdoutData.empty());
+    assert(g.result(ones).stdoutBytes > 100'000);
+
+    std::cout << "Test 1 passed.\n";
+}
+
+void test_input_order() {
+    std::cout << "\n===== TEST 2: own input first, then producers in edge order =====\n";
+
+    JobGraph g;
+    auto a = g.add("a", "sh", {"-c", "sleep 0.2; echo a"});
+    auto b = g.add("b", "sh", {"-c", "echo b"});
+    auto c = g.add("c", "/bin/cat", {});
+    g.setInput(c, "head\n");
+    g.pipe(a, c);
+    g.pipe(b, c);
+
+    bool ok = g.run();
+    assert(ok);
+    assert(g.result(c).stdoutData == "head\na\nb\n");
+
+    std::cout << "Test 2 passed.\n";
+}
+
+void test_parallel_and_critical_path() {
+    std::cout << "\n===== TEST 3: parallel scheduling and critical path =====\n";
+
+    JobGraph g;
+    g.setConcurrency(4);
+    auto fast1 = g.add("fast1", "sleep", {"0.1"});
+    auto fast2 = g.add("fast2", "sleep", {"0.1"});
+    auto slow  = g.add("slow",  "sleep", {"0.4"});
+    auto last  = g.add("last",  "sleep", {"0.1"});
+    g.after(fast1, last);
+    g.after(fast2, last);
+    g.after(slow, last);
+
+    auto t0 = Clock::now();
+    bool ok = g.run();
+    double took = std::chrono::duration<double>(Clock::now() - t0).count();
+    std::cout << g.report() << "took " << took << " s\n";
+    assert(ok);
+
+    // Serial would be 0.7 s; the graph's depth is 0.5 s.
+    assert(took < 0.65);
+    std::vector<JobGraph::NodeId> path = g.criticalPath();
+    assert(path.size() == 2 && path[0] == slow && path[1] == last);
+    assert(g.result(last).started >= g.result(slow).finished);
+
+    std::cout << "Test 3 passed.\n";
+}
+
+void test_concurrency_limit() {
+    std::cout << "\n===== TEST 4: concurrency limit =====\n";
+
+    JobGraph g;
+    g.setConcurrency(1);
+    for (int i = 0; i < 3; i++)
+        g.add("s" + std::to_string(i), "sleep", {"0.1"});
+
+    auto t0 = Clock::now();
+    bool ok = g.run();
+    double took = std::chrono::duration<double>(Clock::now() - t0).count();
+    assert(ok);
+    assert(took >= 0.3);
+
+    std::cout << "Test 4 passed.\n";
+}
+
+void test_failure_skips_dependents() {
+    std::cout << "\n===== TEST 5: a failing node skips its dependents =====\n";
+
+    JobGraph g;
+    auto bad   = g.add("bad",   "sh", {"-c", "echo broken >&2; exit 2"});
+    auto dep   = g.add("dep",   "echo", {"never"});
+    auto chain = g.add("chain", "echo", {"never"});
+    auto other = g.add("other", "echo", {"fine"});
+    g.after(bad, dep);
+    g.pipe(dep, chain);
+
+    bool ok = g.run();
+    std::cout << g.report();
+    assert(!ok);
+    assert(g.result(bad).state == JobGraph::NodeState::Failed);
+    assert(g.result(bad).status.code == 2);
+    assert(g.result(bad).stderrData == "broken\n");
+    assert(g.result(dep).state == JobGraph::NodeState::Skipped);
+    assert(g.result(chain).state == JobGraph::NodeState::Skipped);
+    assert(g.result(other).stdoutData == "fine\n");
+
+    bool threw = false;
+    JobGraph cyclic;
+    auto x = cyclic.add("x", "true", {});
+    auto y = cyclic.add("y", "true", {});
+    cyclic.after(x, y);
+    cyclic.after(y, x);
+    try {
+        cyclic.run();
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    std::cout << "Test 5 passed.\n";
+}
+
+void test_sigpipe_per_thread() {
+    std::cout << "\n===== TEST 6: graphs on two threads, a consumer that quits early =====\n";
+
+    // 'early' exits without reading its 10 MB of input, so the parent's
+    // writes fail with EPIPE. Meanwhile a quick graph on another thread
+    // starts and finishes; its SIGPIPE handling must not end the other's.
+    JobGraph slow;
+    auto early = slow.add("early", "sh", {"-c", "sleep 0.3; exit 0"});
+    slow.setInput(early, std::string(10 << 20, 'x'));
+    // Children do not inherit the parent's blocked SIGPIPE.
+    auto selfKill = slow.add("selfKill", "sh", {"-c", "kill -PIPE $$; exit 0"});
+
+    std::thread quick([] {
+        JobGraph g;
+        g.add("echo", "echo", {"hi"});
+        g.run();
+    });
+    slow.run();
+    quick.join();
+
+    assert(slow.result(early).status.exited && slow.result(early).status.code == 0);
+    assert(slow.result(selfKill).status.signal == SIGPIPE);
+
+    std::cout << "Test 6 passed.\n";
+}
+
+void test_backpressure() {
+    std::cout << "\n===== TEST 0: a slow consumer holds its producer back =====\n";
+
+    rusage before{};
+    getrusage(RUSAGE_SELF, &before);
+
+    const long total = 128L << 20;
+    JobGraph g;
+    g.setConcurrency(2);  // a consumer that cannot start yet holds nothing back
+    auto gen  = g.add("gen",  "head", {"-c", std::to_string(total), "/dev/zero"});
+    auto slow = g.add("slow", "sh",   {"-c", "sleep 0.5; wc -c"});
+    g.pipe(gen, slow);
+
+    bool ok = g.run();
+    assert(ok);
+    assert(std::stol(g.result(slow).stdoutData) == total);
+    assert(g.result(gen).stdoutBytes == static_cast<std::uint64_t>(total));
+    assert(g.result(gen).stdoutData.empty());
+
+    // Reading ahead of the consumer would have buffered all 128 MiB.
+    rusage after{};
+    getrusage(RUSAGE_SELF, &after);
+    long grownKb = after.ru_maxrss - before.ru_maxrss;
+    std::cout << "peak RSS grew by " << grownKb << " KiB\n";
+    assert(grownKb < 32 * 1024);
+
+    std::cout << "Test 0 passed.\n";
+}
+
+int main() {
+    // Before anything else raises the process's peak RSS.
+    test_backpressure();
+    test_streamed_edges();
+    test_input_order();
+    test_parallel_and_critical_path();
+    test_concurrency_limit();
+    test_failure_skips_dependents();
+    test_sigpipe_per_thread();
+
+    std::cout << "\nAll job graph tests passed.\n";
+    return 0;
+}
+
+#else
+
+int main() {
+    std::cout << "JobGraph tests use POSIX tools; skipped on Windows.\n";
+    return 0;
+}
+
+#endif
@@ -0,0 +1,97 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+
+#include "../include/IPC.h"
+
+static const ipc::ChannelMetrics* find(const ipc::MetricsSnapshot& m, ChannelKind kind,
+                                       const std::string& suffix) {
+    for (auto& c : m.channels)
+        if (c.kind == kind && c.label.size() >= suffix.size() &&
+            c.label.compare(c.label.size() - suffix.size(), suffix.size(), suffix) == 0)
+            return &c;
+    return nullptr;
+}
+
+void test_pipe_counters() {
+    std::cout << "\n===== TEST 1: Pipe counters of a child =====\n";
+
+#ifdef _WIN32
+    ipc::Process p("findstr", {"x"});
+#else
+    ipc::Process p("/bin/cat", {});
+#endif
+    bool ok = p.start();
+    assert(ok);
+
+    p.writeStdin("x1\n");
+    p.writeStdin("x2\n");
+    p.closeStdin();
+    p.wait();
+    std::string out = p.readStdout();
+
+    ipc::MetricsSnapshot m = ipc::metrics();
+    const ipc::ChannelMetrics* in = find(m, ChannelKind::Pipe, "] stdin");
+    const ipc::ChannelMetrics* stdOut = find(m, ChannelKind::Pipe, "] stdout");
+    assert(in && stdOut);
+
+    std::cout << m.toText();
+    assert(in->stats.messagesOut == 2);
+    assert(in->stats.bytesOut == 6);
+    assert(in->stats.syscalls >= 2);
+    assert(stdOut->stats.bytesIn == out.size());
+    assert(m.total(ChannelKind::Pipe).bytesOut >= 6);
+
+    std::cout << "Test 1 passed.\n";
+}
+
+void test_semaphore_counters() {
+    std::cout << "\n===== TEST 2: Semaphore counters =====\n";
+
+    ipc::Semaphore sem;
+    sem.initAnonymous(0);
+    sem.counters().setLabel("test sem");
+
+    sem.post();
+    sem.post();
+    bool ok = sem.wait() && sem.wait();
+    assert(ok);
+    ok = sem.waitFor(20);
+    assert(!ok);
+
+    ChannelStats s = sem.counters().snapshot();
+    assert(s.messagesOut == 2);
+    assert(s.messagesIn == 2);
+    assert(s.waits == 1);
+    assert(s.waitNanos >= 10'000'000ull);
+
+    std::string json = ipc::metrics().toJson();
+    assert(json.find("\"label\":\"test sem\"") != std::string::npos);
+
+    std::cout << "Test 2 passed.\n";
+}
+
+void test_retired_totals() {
+    std::cout << "\n===== TEST 3: Closed channels stay in the totals =====\n";
+
+    uint64_t before = ipc::metrics().total(ChannelKind::SharedMemory).bytesOut;
+    {
+        ipc::SharedMemory shm;
+        bool ok = shm.createAnonymous(4096);
+        assert(ok);
+        shm.write("twelve bytes");
+    }
+    uint64_t after = ipc::metrics().total(ChannelKind::SharedMemory).bytesOut;
+    assert(after == before + 12);
+
+    std::cout << "Test 3 passed.\n";
+}
+
+int main() {
+    test_pipe_counters();
+    test_semaphore_counters();
+    test_retired_totals();
+
+    std::cout << "\nAll metrics tests passed.\n";
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <algorithm>
+
+#include "../include/Process.h"
+#include "../include/OutputSpool.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <cstdlib>
+#endif
+
+void test_small_output_stays_in_memory() {
+    std::cout << "\n===== TEST 1: small output stays in memory =====\n";
+
+#ifdef _WIN32
+    Process p("cmd", {"/C", "echo Hello"});
+#else
+    Process p("/bin/echo", {"Hello"});
+#endif
+    bool ok = p.start();
+    assert(ok);
+
+    OutputSpool spool;
+    p.readStdoutTo(spool);
+    p.wait();
+
+    assert(!spool.spilled());
+    assert(spool.view().substr(0, 5) == "Hello");
+
+    std::cout << "Test 1 passed.\n";
+}
+
+void test_append_across_threshold() {
+    std::cout << "\n===== TEST 2: appends spill to a mapped file =====\n";
+
+    OutputSpool spool(1000);
+    std::string expected;
+    for (int i = 0; i < 500; i++) {
+        std::string chunk = "chunk " + std::to_string(i) + ";";
+        spool.append(chunk);
+        expected += chunk;
+        if (i == 10) {
+            assert(spool.view() == expected);
+        }
+    }
+
+    assert(spool.spilled());
+    assert(spool.size() == expected.size());
+    assert(spool.view() == expected);
+
+    spool.append("tail");
+    expected += "tail";
+    assert(spool.view() == expected);
+
+    spool.clear();
+    assert(spool.size() == 0 && !spool.spilled());
+
+    std::cout << "Test 2 passed.\n";
+}
+
+#ifndef _WIN32
+void test_large_child_output() {
+    std::cout << "\n===== TEST 3: tens of MB from a child through the spool =====\n";
+
+    const int N = 3000000;
+    Process p("seq", {"1", std::to_string(N)});
+    bool ok = p.start();
+    assert(ok);
+
+    OutputSpool spool(1 << 20);
+    std::uint64_t got = p.readStdoutTo(spool);
+    p.wait();
+
+    std::string_view v = spool.view();
+    std::cout << "spooled " << got << " bytes, spilled: " << spool.spilled() << "\n";
+    assert(spool.spilled());
+    assert(got == spool.size() && v.size() == got);
+    assert(std::count(v.begin(), v.end(), '\n') == N);
+    assert(v.substr(0, 4) == "1\n2\n");
+    assert(v.substr(v.size() - 8) == "3000000\n");
+
+    std::cout << "Test 3 passed.\n";
+}
+
+void test_read_from_regular_file() {
+    std::cout << "\n===== TEST 4: a spilled spool reads a non-pipe fd =====\n";
+
+    // splice() refuses a regular file as its source; the spool falls back
+    // to read() and keeps going.
+    char path[] = "/tmp/spool_source_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd != -1);
+    unlink(path);
+    std::string content;
+    for (int i = 0; i < 20000; i++) content += "line " + std::to_string(i) + "\n";
+    ssize_t put = ::write(fd, content.data(), content.size());
+    assert(put == static_cast<ssize_t>(content.size()));
+    (void)put;
+    lseek(fd, 0, SEEK_SET);
+
+    OutputSpool spool(16);
+    spool.append("header that spills\n");
+    assert(spool.spilled());
+    std::uint64_t got = spool.readFrom(fd);
+    ::close(fd);
+
+    assert(got == content.size());
+    assert(spool.view() == "header that spills\n" + content);
+
+    std::cout << "Test 4 passed.\n";
+}
+#endif
+
+int main() {
+    test_small_output_stays_in_memory();
+    test_append_across_threshold();
+#ifndef _WIN32
+    test_large_child_output();
+    test_read_from_regular_file();
+#endif
+
+    std::cout << "\nAll output spool tests passed.\n";
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <stdexcept>
+#include <csignal>
+
+#include "../include/Pipeline.h"
+#include "../include/SpawnServer.h"
+
+#ifndef _WIN32
+
+void test_streamed_stages() {
+    std::cout << "\n===== TEST 1: seq | grep | wc, all stages concurrent =====\n";
+
+    const int N = 200000;
+    int expected = 0;
+    for (int i = 1; i <= N; i++)
+        if (std::to_string(i).find('7') != std::string::npos) expected++;
+
+    Pipeline p;
+    p.add("seq", {"1", std::to_string(N)})
+     .add("grep", {"7"})
+     .add("wc", {"-l"});
+
+    bool ok = p.start();
+    assert(ok);
+    p.closeStdin();
+
+    std::string out = p.readStdout();
+    std::vector<int> codes = p.wait();
+    std::cout << "[parent] wc -l: " << out;
+
+    assert(std::stoi(out) == expected);
+    assert(codes.size() == 3 && p.succeeded());
+
+    std::cout << "Test 1 passed.\n";
+}
+
+void test_parent_stdin() {
+    std::cout << "\n===== TEST 2: parent feeds the first stage =====\n";
+
+    Pipeline p;
+    p.add("tr", {"a-z", "A-Z"}).add("/bin/cat", {});
+
+    bool ok = p.start();
+    assert(ok);
+    p.writeStdin("hello pipeline\n");
+    p.closeStdin();
+
+    std::string out = p.readStdout();
+    p.wait();
+    assert(out == "HELLO PIPELINE\n");
+
+    std::cout << "Test 2 passed.\n";
+}
+
+void test_stage_status_and_stderr() {
+    std::cout << "\n===== TEST 3: per-stage exit status and stderr =====\n";
+
+    Pipeline p;
+    p.add("sh", {"-c", "echo data; echo oops >&2; exit 3"})
+     .add("/bin/cat", {});
+
+    bool ok = p.start();
+    assert(ok);
+    p.closeStdin();
+
+    std::string out = p.readStdout();
+    std::vector<int> codes = p.wait();
+
+    assert(out == "data\n");
+    assert(p.readStderr(0) == "oops\n");
+    assert(codes[0] == 3 && codes[1] == 0);
+    assert(!p.succeeded());
+
+    std::cout << "Test 3 passed.\n";
+}
+
+void test_failed_stage_reaps_earlier_ones() {
+    std::cout << "\n===== TEST 4: a stage that fails to start takes down the others =====\n";
+
+    // Spawning through a server that was never started throws.
+    SpawnServer stopped;
+    SpawnOptions viaServer;
+    viaServer.spawnServer = &stopped;
+
+    Pipeline p;
+    p.add("sleep", {"30"})
+     .add("/bin/cat", {}, viaServer);
+
+    bool threw = false;
+    try {
+        p.start();
+    } catch (const std::runtime_error& e) {
+        std::cout << "start failed: " << e.what() << "\n";
+        threw = true;
+    }
+    assert(threw);
+    assert(p.exitStatus(0).signal == SIGKILL);
+
+    std::cout << "Test 4 passed.\n";
+}
+
+int main() {
+    test_streamed_stages();
+    test_parent_stdin();
+    test_stage_status_and_stderr();
+    test_failed_stage_reaps_earlier_ones();
+
+    std::cout << "\nAll pipeline tests passed.\n";
+    return 0;
+}
+
+#else
+
+int main() {
+    std::cout << "Pipeline tests use POSIX tools; skipped on Windows.\n";
+    return 0;
+}
+
+#endif
@@ -1,6 +1,9 @@
 // This is a demo version of PVS-Studio for educational use.
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: https://pvs-studio.com
 #include <iostream>
+#include <array>
+#include <chrono>
+#include <set>
 #include "../include/Process.h"
 
 int main() {
@@ -133,6 +136,144 @@ int main() {
         std::cout << "exit code: " << code << "\n\n";
     }
 
+    {
+        std::cout << "Test 7: Killed by signal (correct: signal 9)\n";
+        Process p("/bin/sleep", {"10"});
+        if (!p.start()) { std::cerr << "Failed to start process\n"; return 1; }
+        p.terminate();
+        int code = p.wait();
+        std::cout << "exit code: " << code << ", signal: " << p.exitStatus().signal << "\n\n";
+    }
+
+    {
+        std::cout << "Test 8: waitAny returns the first child to exit (correct: 1)\n";
+        std::array<Process, 3> ps{
+            Process("/bin/sleep", {"2"}),
+            Process("/bin/sleep", {"0.2"}),
+            Process("/bin/sleep", {"1"}),
+        };
+        for (auto& p : ps)
+            if (!p.start()) { std::cerr << "Failed to start process\n"; return 1; }
+
+        Process* first = Process::waitAny(ps);
+        std::cout << "first: " << (first - ps.data()) << "\n";
+        while (Process::waitAny(ps)) {}
+        std::cout << "all reaped\n\n";
+    }
+
+    {
+        std::cout << "Test 9: Resource usage of a CPU-bound child\n";
+        Process p("/bin/sh", {"-c", "i=0; while [ $i -lt 200000 ]; do i=$((i+1)); done"});
+        if (!p.start()) { std::cerr << "Failed to start process\n"; return 1; }
+        int code = p.wait();
+        const ProcessStats& st = p.stats();
+        std::cout << "user cpu: " << st.userCpuSeconds << " s, sys cpu: " << st.systemCpuSeconds << " s\n";
+        std::cout << "max rss: " << st.maxRssKb << " KiB, minor faults: " << st.minorPageFaults << "\n";
+        std::cout << "wall: " << std::chrono::duration<double>(st.wallTime).count() << " s\n";
+        std::cout << "exit code: " << code << "\n\n";
+    }
+
+    {
+        std::cout << "Test 10: CPU affinity (correct: Cpus_allowed_list: 0)\n";
+        SpawnOptions opts;
+        opts.cpus = {0};
+        opts.numaNode = 0;
+        Process p("/bin/grep", {"Cpus_allowed_list", "/proc/self/status"}, opts);
+        if (!p.start()) { std::cerr << "Failed to start process\n"; return 1; }
+        int code = p.wait();
+        std::cout << "stdout:\n" << p.readStdout();
+        std::cout << "exit code: " << code << "\n\n";
+    }
+
+    {
+        std::cout << "Test 11: Child inherits only stdio (correct: 0 1 2 3, 3 is ls's own)\n";
+        Process other("/bin/cat", {});
+        if (!other.start()) { std::cerr << "Failed to start process\n"; return 1; }
+
+        Process p("/bin/ls", {"/proc/self/fd"});
+        if (!p.start()) { std::cerr << "Failed to start process\n"; return 1; }
+        int code = p.wait();
+        std::cout << "stdout:\n" << p.readStdout();
+        std::cout << "exit code: " << code << "\n\n";
+
+        other.closeStdin();
+        other.wait();
+    }
+
+    {
+        std::cout << "Test 12: Working directory, environment and respawn (correct: /tmp bar, twice)\n";
+        SpawnOptions opts;
+        opts.workingDirectory = "/tmp";
+        opts.environment = std::vector<std::string>{"FOO=bar"};
+        Process p("sh", {"-c", "echo $(pwd) $FOO"}, opts);
+        for (int i = 0; i < 2; i++) {
+            if (!p.start()) { std::cerr << "Failed to start process\n"; return 1; }
+            int code = p.wait();
+            std::cout << "stdout:\n" << p.readStdout();
+            std::cout << "exit code: " << code << "\n";
+        }
+        std::cout << "\n";
+    }
+
+    {
+        std::cout << "Test 13: Batched stdin (correct: 1000 lines, then 3 more)\n";
+        Process p("/bin/sh", {"-c", "wc -l"});
+        if (!p.start()) { std::cerr << "Failed to start process\n"; return 1; }
+
+        std::vector<std::string> lines;
+        for (int i = 0; i < 1000; i++) lines.push_back("record " + std::to_string(i) + "\n");
+        std::vector<std::string_view> views(lines.begin(), lines.end());
+        p.writeStdinMany(views);
+
+        p.beginBatch();
+        p.appendStdin("a\n");
+        p.appendStdin("b\n");
+        p.appendStdin("c\n");
+        p.flushStdin();
+        p.closeStdin();
+
+        int code = p.wait();
+        std::cout << "stdout:\n" << p.readStdout();
+        std::cout << "exit code: " << code << "\n\n";
+    }
+
+    {
+        std::cout << "Test 14: startAuto with small messages (correct: pipe, hi)\n";
+        Process p("/bin/cat", {});
+        TransportHints hints;
+        hints.messageSize = 64;
+        hints.messagesPerSecond = 100;
+        if (!p.startAuto(hints)) { std::cerr << "Failed to start process\n"; return 1; }
+        std::cout << "transport: " << to_string(p.transport()) << "\n";
+        p.writeStdin("hi\n");
+        p.closeStdin();
+        int code = p.wait();
+        std::cout << "stdout:\n" << p.readStdout();
+        std::cout << "exit code: " << code << "\n\n";
+    }
+
+    {
+        std::cout << "Test 15: spawnMany (correct: 128 children, 128 distinct replies, all exit 0)\n";
+        Process prototype("/bin/sh", {"-c", "read x; echo $x $$"});
+        auto t0 = std::chrono::steady_clock::now();
+        auto procs = Process::spawnMany(128, prototype);
+        double took = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+        for (size_t i = 0; i < procs.size(); i++) {
+            procs[i]->writeStdin("child" + std::to_string(i) + "\n");
+            procs[i]->closeStdin();
+        }
+        std::set<std::string> replies;
+        int failures = 0;
+        for (size_t i = 0; i < procs.size(); i++) {
+            std::string out = procs[i]->readStdout();
+            if (out.rfind("child" + std::to_string(i) + " ", 0) == 0) replies.insert(out);
+            if (procs[i]->wait() != 0) failures++;
+        }
+        std::cout << "children: " << procs.size() << ", distinct replies: " << replies.size()
+                  << ", failures: " << failures << " (spawned in " << took << " ms)\n\n";
+    }
+
 #endif
 
     std::cout << "All tests done.\n";
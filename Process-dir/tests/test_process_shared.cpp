@@ -1,6 +1,8 @@
 #include <iostream>
 #include <cassert>
 #include <string>
+#include <string_view>
+#include <stdexcept>
 #include "../include/Process.h"
 
 void test_basic_exchange() {
@@ -102,10 +104,191 @@ void test_large_message() {
     p.wait();
 }
 
+void test_anonymous_segments() {
+    std::cout << "\n===== TEST 4: Anonymous (memfd) segments =====\n";
+
+#ifdef _WIN32
+    std::string exe = "test_child_shared.exe";
+#else
+    std::string exe = "./test_child_shared";
+#endif
+
+    Process p(exe, {});
+
+    bool ok = p.startSharedMemory(4096, SharedMemoryMode::Anonymous);
+    assert(ok);
+
+    for (int i = 0; i < 3; i++) {
+        std::string msg = "anon_" + std::to_string(i);
+        p.writeStdin(msg);
+
+        std::string out = p.readStdout();
+        std::cout << "exchange " << i << ": " << out << "\n";
+
+        assert(out == "child: " + msg);
+    }
+
+    p.writeStdin("exit");
+    p.wait();
+
+    std::cout << "Test 4 passed.\n";
+}
+
+void test_concurrent_children() {
+    std::cout << "\n===== TEST 5: Concurrent shared-memory children =====\n";
+
+#ifdef _WIN32
+    std::string exe = "test_child_shared.exe";
+#else
+    std::string exe = "./test_child_shared";
+#endif
+
+    Process a(exe, {});
+    Process b(exe, {});
+
+    bool ok = a.startSharedMemory() && b.startSharedMemory();
+    assert(ok);
+    assert(SharedMemoryRegistry::instance().active() >= 2);
+
+    for (int i = 0; i < 3; i++) {
+        a.writeStdin("a" + std::to_string(i));
+        b.writeStdin("b" + std::to_string(i));
+
+        std::string outA = a.readStdout();
+        std::string outB = b.readStdout();
+        std::cout << "exchange " << i << ": " << outA << " | " << outB << "\n";
+
+        assert(outA == "child: a" + std::to_string(i));
+        assert(outB == "child: b" + std::to_string(i));
+    }
+
+    a.writeStdin("exit");
+    b.writeStdin("exit");
+    a.wait();
+    b.wait();
+
+    std::cout << "Test 5 passed.\n";
+}
+
+void test_stderr_and_eof() {
+    std::cout << "\n===== TEST 6: stderr stream and stdin EOF =====\n";
+
+#ifdef _WIN32
+    std::string exe = "test_child_shared.exe";
+#else
+    std::string exe = "./test_child_shared";
+#endif
+
+    Process p(exe, {});
+
+    bool ok = p.startSharedMemory(4096, SharedMemoryMode::Anonymous);
+    assert(ok);
+
+    p.writeStdin("one");
+    std::string out = p.readStdout();
+    assert(out == "child: one");
+
+    // No "exit" message: closing stdin alone must end the child's loop.
+    p.closeStdin();
+
+    std::string err = p.readStderr();
+    std::cout << "[parent] stderr: " << err << "\n";
+    assert(err == "child handled 1");
+
+    // Both output streams are shut down, so further reads return at once.
+    assert(p.readStderr().empty());
+    assert(p.readStdout().empty());
+
+    int code = p.wait();
+    assert(code == 0);
+
+    std::cout << "Test 6 passed.\n";
+}
+
+void test_batched_stdin() {
+    std::cout << "\n===== TEST 7: Batched stdin, one wakeup =====\n";
+
+#ifdef _WIN32
+    std::string exe = "test_child_shared.exe";
+#else
+    std::string exe = "./test_child_shared";
+#endif
+
+    Process p(exe, {});
+
+    bool ok = p.startSharedMemory();
+    assert(ok);
+
+    std::string_view records[] = { "r1;", "r2;", "r3;" };
+    p.writeStdinMany(records);
+    std::string out = p.readStdout();
+    std::cout << "[parent] got: " << out << "\n";
+    assert(out == "child: r1;r2;r3;");
+
+    p.beginBatch();
+    for (int i = 0; i < 4; i++)
+        p.appendStdin("x");
+    p.flushStdin();
+    out = p.readStdout();
+    assert(out == "child: xxxx");
+
+    bool threw = false;
+    try {
+        std::string big(8192, 'B');
+        std::string_view one[] = { big };
+        p.writeStdinMany(one);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    p.writeStdin("exit");
+    p.wait();
+
+    std::cout << "Test 7 passed.\n";
+}
+
+void test_auto_transport() {
+    std::cout << "\n===== TEST 8: startAuto picks shared memory for bulk messages =====\n";
+
+#ifdef _WIN32
+    std::string exe = "test_child_shared.exe";
+#else
+    std::string exe = "./test_child_shared";
+#endif
+
+    Process p(exe, {});
+
+    TransportHints hints;
+    hints.messageSize = 256 * 1024;
+    hints.supported = Transport::Pipe | Transport::SharedMemory;
+
+    bool ok = p.startAuto(hints);
+    assert(ok);
+    std::cout << "[parent] transport: " << to_string(p.transport()) << "\n";
+    assert(p.transport() == Transport::SharedMemory);
+
+    std::string big(hints.messageSize - 16, 'M');
+    p.writeStdin(big);
+    std::string out = p.readStdout();
+    assert(out == "child: " + big);
+
+    p.writeStdin("exit");
+    int code = p.wait();
+    assert(code == 0);
+
+    std::cout << "Test 8 passed.\n";
+}
+
 int main() {
     test_basic_exchange();
     test_multiple_rounds();
     test_large_message();
+    test_anonymous_segments();
+    test_concurrent_children();
+    test_stderr_and_eof();
+    test_batched_stdin();
+    test_auto_transport();
 
     std::cout << "\nAll shared memory IPC tests passed.\n";
     return 0;
@@ -0,0 +1,336 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <stdexcept>
+#include <functional>
+
+#include "../include/RpcChannel.h"
+#include "../include/Process.h"
+
+#ifndef _WIN32
+#include <csignal>
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+static const char* SERVER = "./test_child_rpc";
+
+void test_pipelined_futures() {
+    std::cout << "\n===== TEST 1: many requests in flight over a child's pipes =====\n";
+
+    Process child(SERVER, {});
+    child.start();
+    {
+        RpcChannel rpc(child);
+
+        auto t0 = Clock::now();
+        for (int i = 0; i < 200; i++) {
+            std::string reply = rpc.call("0 serial" + std::to_string(i)).get();
+            assert(reply == "serial" + std::to_string(i));
+        }
+        double serial = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+
+        t0 = Clock::now();
+        std::vector<std::future<std::string>> replies;
+        for (int i = 0; i < 200; i++)
+            replies.push_back(rpc.call("0 piped" + std::to_string(i)));
+        for (int i = 0; i < 200; i++) {
+            std::string reply = replies[i].get();
+            assert(reply == "piped" + std::to_string(i));
+        }
+        double piped = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        std::cout << "200 calls: one at a time " << serial << " ms, 32 in flight " << piped << " ms\n";
+
+        assert(rpc.inFlight() == 0);
+    }
+    int rc = child.wait();
+    assert(rc == 0);
+    std::cout << "Test 1 passed.\n";
+}
+
+void test_callbacks_and_limit() {
+    std::cout << "\n===== TEST 2: callbacks, bounded in-flight window =====\n";
+
+    Process child(SERVER, {});
+    child.start();
+    {
+        RpcChannel rpc(child, 4);
+        std::atomic<int> done{0};
+        std::atomic<size_t> maxSeen{0};
+        for (int i = 0; i < 20; i++) {
+            size_t now = rpc.inFlight();
+            if (now > maxSeen) maxSeen = now;
+            rpc.call("2 cb" + std::to_string(i), [&done, i](bool ok, std::string reply) {
+                assert(ok && reply == "cb" + std::to_string(i));
+                done++;
+            });
+        }
+        rpc.close();
+        std::cout << "completed " << done << ", max in flight seen " << maxSeen << "\n";
+        assert(done == 20);
+        assert(maxSeen <= 4);
+
+        bool threw = false;
+        try {
+            rpc.call("0 late");
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+    int rc = child.wait();
+    assert(rc == 0);
+    std::cout << "Test 2 passed.\n";
+}
+
+void test_peer_dies() {
+    std::cout << "\n===== TEST 3: outstanding calls fail when the server dies =====\n";
+
+    Process child(SERVER, {});
+    child.start();
+    {
+        RpcChannel rpc(child);
+        std::future<std::string> first = rpc.call("0 before");
+        std::future<std::string> crash = rpc.call("crash");
+        std::future<std::string> after = rpc.call("0 after");
+
+        std::string before = first.get();
+        assert(before == "before");
+        int failed = 0;
+        for (auto* f : { &crash, &after }) {
+            try {
+                f->get();
+            } catch (const std::runtime_error&) {
+                failed++;
+            }
+        }
+        assert(failed == 2);
+    }
+    int rc = child.wait();
+    assert(rc == 3);
+    std::cout << "Test 3 passed.\n";
+}
+
+void test_shared_queues() {
+    std::cout << "\n===== TEST 4: RPC over a pair of shared work queues =====\n";
+
+    SharedWorkQueue reqClient, respClient, reqServer, respServer;
+    bool ok = reqClient.create("/test_rpc_requests", 64, 256);
+    assert(ok);
+    ok = respClient.create("/test_rpc_responses", 64, 256);
+    assert(ok);
+    ok = reqServer.open("/test_rpc_requests", 64, 256);
+    assert(ok);
+    ok = respServer.open("/test_rpc_responses", 64, 256);
+    assert(ok);
+
+    std::thread serverThread([&] {
+        RpcServer server(respServer, reqServer);
+        server.serve([](std::string_view request) { return "re:" + std::string(request); });
+    });
+
+    {
+        RpcChannel rpc(reqClient, respClient);
+        std::vector<std::future<std::string>> replies;
+        for (int i = 0; i < 100; i++)
+            replies.push_back(rpc.call(std::to_string(i)));
+        for (int i = 0; i < 100; i++) {
+            std::string reply = replies[i].get();
+            assert(reply == "re:" + std::to_string(i));
+        }
+
+        bool threw = false;
+        try {
+            rpc.call(std::string(300, 'x'));
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw);
+        // The refused request must not hold an in-flight slot.
+        assert(rpc.inFlight() == 0);
+    }
+    serverThread.join();
+    std::cout << "Test 4 passed.\n";
+}
+
+void test_queue_peer_killed() {
+    std::cout << "\n===== TEST 5: queue server killed with calls outstanding =====\n";
+
+    for (bool watchPeer : { true, false }) {
+        SharedWorkQueue requests, responses;
+        bool ok = requests.create("/test_rpc_kill_req", 64, 256);
+        assert(ok);
+        ok = responses.create("/test_rpc_kill_resp", 64, 256);
+        assert(ok);
+
+        Process child(SERVER, { "--queues", "/test_rpc_kill_req", "/test_rpc_kill_resp" });
+        child.start();
+
+        // Shared memory gives no EOF; the test flips this once the server
+        // has been reaped.
+        std::atomic<bool> serverUp{true};
+        std::function<bool()> peerAlive;
+        if (watchPeer)
+            peerAlive = [&serverUp] { return serverUp.load(); };
+
+        std::vector<std::future<std::string>> replies;
+        Clock::time_point killed;
+        {
+            RpcChannel rpc(requests, responses, RpcChannel::defaultInFlight, peerAlive);
+            // The server must be attached before it is killed.
+            std::string up = rpc.call("0 up").get();
+            assert(up == "up");
+            for (int i = 0; i < 3; i++)
+                replies.push_back(rpc.call("10000 never"));
+
+            child.terminate();
+            child.wait();
+            serverUp = false;
+            killed = Clock::now();
+
+            if (watchPeer) {
+                // The reader notices on its own, without close().
+                bool threw = false;
+                try {
+                    replies[0].get();
+                } catch (const std::runtime_error&) {
+                    threw = true;
+                }
+                assert(threw);
+                replies.erase(replies.begin());
+            }
+        }
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - killed).count();
+        std::cout << (watchPeer ? "with" : "without") << " a peer check: channel gone " << ms << " ms after the kill\n";
+        assert(ms < 5000);
+
+        for (auto& f : replies) {
+            bool threw = false;
+            try {
+                f.get();
+            } catch (const std::runtime_error&) {
+                threw = true;
+            }
+            assert(threw);
+        }
+    }
+    std::cout << "Test 5 passed.\n";
+}
+
+void test_close_from_callback() {
+    std::cout << "\n===== TEST 6: close() called from a callback =====\n";
+
+    Process child(SERVER, {});
+    child.start();
+    {
+        RpcChannel rpc(child);
+        std::atomic<int> done{0};
+        std::future<std::string> earlier = rpc.call("0 earlier");
+        rpc.call("20 last", [&](bool ok, std::string reply) {
+            assert(ok && reply == "last");
+            rpc.close();
+            done++;
+        });
+        std::string reply = earlier.get();
+        assert(reply == "earlier");
+        while (done == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        bool threw = false;
+        try {
+            rpc.call("0 late");
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+    int rc = child.wait();
+    assert(rc == 0);
+    std::cout << "Test 6 passed.\n";
+}
+
+// True if the call is refused, or its future fails, within 'limitMs'.
+static bool failsWithin(RpcChannel& rpc, const std::string& request, double limitMs) {
+    auto t0 = Clock::now();
+    bool failed = false;
+    try {
+        rpc.call(request).get();
+    } catch (const std::runtime_error&) {
+        failed = true;
+    }
+    return failed && std::chrono::duration<double, std::milli>(Clock::now() - t0).count() < limitMs;
+}
+
+void test_full_queue_without_server() {
+    std::cout << "\n===== TEST 7: a full request queue nobody drains =====\n";
+
+    // Two slots and no server: the first two requests fill the queue.
+    SharedWorkQueue requests, responses;
+    bool ok = requests.create("/test_rpc_full_req", 2, 64);
+    assert(ok);
+    ok = responses.create("/test_rpc_full_resp", 2, 64);
+    assert(ok);
+
+    std::future<std::string> a, b;
+    auto t0 = Clock::now();
+    {
+        RpcChannel rpc(requests, responses);
+        a = rpc.call("a");
+        b = rpc.call("b");
+        // close() cannot even queue its close frame; it gives up on it.
+    }
+    double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    std::cout << "close() returned after " << ms << " ms\n";
+    assert(ms < 2 * RpcChannel::closeGrace.count() + 1000);
+    for (auto* f : { &a, &b }) {
+        bool threw = false;
+        try {
+            f->get();
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    // With a peer check, a request that finds no room fails once the check
+    // does, instead of waiting for room.
+    ok = requests.create("/test_rpc_full_req", 2, 64);
+    assert(ok);
+    ok = responses.create("/test_rpc_full_resp", 2, 64);
+    assert(ok);
+    std::atomic<bool> serverUp{true};
+    {
+        RpcChannel rpc(requests, responses, RpcChannel::defaultInFlight, [&serverUp] { return serverUp.load(); });
+        a = rpc.call("a");
+        b = rpc.call("b");
+        std::thread third([&rpc] {
+            bool failed = failsWithin(rpc, "c", 2000);
+            assert(failed);
+            (void)failed;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        serverUp = false;
+        third.join();
+    }
+    std::cout << "Test 7 passed.\n";
+}
+
+int main() {
+#ifndef _WIN32
+    // Test 3 may still be writing when the server exits.
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+    test_pipelined_futures();
+    test_callbacks_and_limit();
+    test_peer_dies();
+    test_shared_queues();
+    test_queue_peer_killed();
+    test_close_from_callback();
+    test_full_queue_without_server();
+    std::cout << "\nAll RPC tests passed.\n";
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdint>
+
+#ifndef _WIN32
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+
+#include "../include/SharedArena.h"
+
+static const char* ARENA_NAME = "/test_shared_arena";
+static const size_t ARENA_SIZE = 1 << 20;
+
+struct Node {
+    long value;
+    OffsetPtr<Node> next;
+};
+
+struct Root {
+    OffsetPtr<Node> head;
+    long childSum;
+    char label[32];
+};
+
+#ifndef _WIN32
+void run_child_logic() {
+    // Attach through a fresh mapping, so the segment sits at a different
+    // address than in the parent.
+    SharedArena arena;
+    if (!arena.open(ARENA_NAME, ARENA_SIZE)) {
+        std::cerr << "[child] Failed to open arena\n";
+        _exit(1);
+    }
+
+    Root* root = arena.get<Root>(arena.root());
+    long sum = 0;
+    for (Node* n = root->head.get(); n; n = n->next.get())
+        sum += n->value;
+    root->childSum = sum;
+    _exit(0);
+}
+#endif
+
+int main() {
+    std::cout << "SharedArena tests:\n";
+
+    SharedArena arena;
+    if (!arena.create(ARENA_NAME, ARENA_SIZE)) {
+        std::cerr << "Failed to create arena\n";
+        return 1;
+    }
+
+    {
+        std::cout << "Test 1: free lists reuse blocks\n";
+        SharedArena::offset_t a = arena.allocate(40);
+        SharedArena::offset_t b = arena.allocate(100000);
+        arena.deallocate(a);
+        arena.deallocate(b);
+        SharedArena::offset_t c = arena.allocate(60);
+        SharedArena::offset_t d = arena.allocate(70000);
+
+        if (a && b && c == a && d == b && arena.allocate(ARENA_SIZE) == 0 &&
+            arena.allocate(SIZE_MAX - 4) == 0) std::cout << "[PASSED]\n\n";
+        else std::cout << "[FAILED] a=" << a << " b=" << b << " c=" << c << " d=" << d << "\n\n";
+        arena.deallocate(c);
+        arena.deallocate(d);
+    }
+
+    {
+        std::cout << "Test 2: object graph shared with a child\n";
+        Root* root = arena.construct<Root>();
+        std::strcpy(root->label, "list");
+        long expected = 0;
+        for (long i = 1; i <= 1000; i++) {
+            Node* n = arena.construct<Node>();
+            n->value = i;
+            n->next = root->head.get();
+            root->head = n;
+            expected += i;
+        }
+        root->childSum = 0;
+        arena.setRoot(arena.offsetOf(root));
+
+#ifdef _WIN32
+        std::cout << "[SKIPPED] needs fork()\n\n";
+#else
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::cerr << "Fork failed\n";
+            return 1;
+        }
+        if (pid == 0) run_child_logic();
+        waitpid(pid, nullptr, 0);
+
+        if (root->childSum == expected) std::cout << "[PASSED]\n\n";
+        else std::cout << "[FAILED] Got: " << root->childSum << "\n\n";
+#endif
+    }
+
+    std::cout << "All tests done.\n";
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstring>
+
+#include "../include/Process.h"
+#include "../include/SpawnServer.h"
+
+#ifndef _WIN32
+
+#include <unistd.h>
+
+using Clock = std::chrono::steady_clock;
+
+static double spawn_true_ms(const SpawnOptions& opts, int rounds) {
+    auto t0 = Clock::now();
+    for (int i = 0; i < rounds; i++) {
+        Process p("/bin/true", {}, opts);
+        p.start();
+        p.closeStdin();
+        p.wait();
+    }
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count() / rounds;
+}
+
+void test_pipes_and_status(SpawnServer& server) {
+    std::cout << "\n===== TEST 1: pipe-mode child through the server =====\n";
+
+    SpawnOptions opts;
+    opts.spawnServer = &server;
+    opts.environment = std::vector<std::string>{ "GREETING=hello" };
+    opts.workingDirectory = "/tmp";
+    Process p("/bin/sh", { "-c", "read x; echo $x $GREETING $PPID; pwd; echo oops >&2; exit 7" }, opts);
+    bool ok = p.start();
+    assert(ok);
+
+    p.writeStdin("ping\n");
+    p.closeStdin();
+    std::string out = p.readStdout();
+    std::string err = p.readStderr();
+    int code = p.wait();
+    std::cout << "stdout: " << out << "stderr: " << err << "exit: " << code << "\n";
+
+    std::string expected = "ping hello " + std::to_string(server.serverPid()) + "\n/tmp\n";
+    assert(out == expected);
+    assert(err == "oops\n");
+    assert(code == 7);
+    assert(p.exitStatus().exited);
+    assert(p.stats().wallTime.count() > 0);
+    std::cout << "Test 1 passed.\n";
+}
+
+void test_signal_and_wait_any(SpawnServer& server) {
+    std::cout << "\n===== TEST 2: terminate, tryWait and waitAny =====\n";
+
+    SpawnOptions opts;
+    opts.spawnServer = &server;
+    Process sleeper("/bin/sleep", { "30" }, opts);
+    Process quick("/bin/sh", { "-c", "exit 4" }, opts);
+    sleeper.start();
+    quick.start();
+
+    Process* procs[] = { &sleeper, &quick };
+    Process* first = Process::waitAny(procs);
+    assert(first == &quick);
+    assert(quick.exitStatus().code == 4);
+
+    assert(!sleeper.tryWait());
+    sleeper.terminate();
+    int code = sleeper.wait();
+    assert(code == -1);
+    assert(sleeper.exitStatus().signal == SIGKILL);
+    std::cout << "Test 2 passed.\n";
+}
+
+void test_flat_latency(SpawnServer& server) {
+    std::cout << "\n===== TEST 3: spawn latency as the parent grows =====\n";
+
+    SpawnOptions direct, served;
+    served.spawnServer = &server;
+    double smallDirect = spawn_true_ms(direct, 20);
+    double smallServed = spawn_true_ms(served, 20);
+
+    // Grow the parent by 512 MiB of touched memory.
+    std::vector<char> ballast(512u << 20);
+    for (size_t i = 0; i < ballast.size(); i += 4096) ballast[i] = 1;
+
+    double bigDirect = spawn_true_ms(direct, 20);
+    double bigServed = spawn_true_ms(served, 20);
+    std::cout << "fork from parent: " << smallDirect << " ms -> " << bigDirect << " ms\n";
+    std::cout << "spawn server:     " << smallServed << " ms -> " << bigServed << " ms\n";
+    assert(bigServed < bigDirect);
+    std::cout << "Test 3 passed.\n";
+}
+
+int main() {
+    // Fork the server first, while this process is still small.
+    SpawnServer server;
+    bool ok = server.start();
+    assert(ok && server.running());
+
+    test_pipes_and_status(server);
+    test_signal_and_wait_any(server);
+    test_flat_latency(server);
+    std::cout << "\nAll spawn server tests passed.\n";
+    return 0;
+}
+
+#else
+
+int main() {
+    std::cout << "SpawnServer needs fork() and SCM_RIGHTS; skipped on Windows.\n";
+    return 0;
+}
+
+#endif
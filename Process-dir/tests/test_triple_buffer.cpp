@@ -0,0 +1,149 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <chrono>
+#include <thread>
+
+#ifndef _WIN32
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+
+#include "../include/SharedTripleBuffer.h"
+
+static const char* TRIPLE_NAME = "/test_triple_buffer";
+static const size_t CAPACITY = 8192;
+static const int FRAMES = 50000;
+
+// Every frame is "<n>:" followed by n % 4000 copies of one letter, so a
+// frame the writer touched while the reader held it shows up as a mismatch.
+static std::string make_frame(int n) {
+    std::string body(static_cast<size_t>(n % 4000), static_cast<char>('a' + n % 26));
+    return std::to_string(n) + ":" + body;
+}
+
+static bool consistent(const std::string& s) {
+    size_t colon = s.find(':');
+    if (colon == std::string::npos) return false;
+    int n = std::stoi(s.substr(0, colon));
+    return s == make_frame(n);
+}
+
+#ifndef _WIN32
+// Slow reader: checks every frame it gets, then reports through its exit code.
+void run_reader() {
+    SharedTripleBuffer r;
+    if (!r.open(TRIPLE_NAME, CAPACITY)) _exit(2);
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::string frame;
+    uint64_t last = 0, seen = 0;
+    while (last < static_cast<uint64_t>(FRAMES)) {
+        if (std::chrono::steady_clock::now() - t0 > std::chrono::seconds(10)) _exit(3);
+        if (!r.readLatest(frame)) continue;
+        if (!consistent(frame)) _exit(1);
+        if (r.frontFrame() <= last) _exit(4);
+        last = r.frontFrame();
+        seen++;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    std::cout << "reader saw " << seen << " of " << FRAMES << " frames, skipped " << r.skipped() << std::endl;
+    _exit(seen + r.skipped() == static_cast<uint64_t>(FRAMES) ? 0 : 5);
+}
+#endif
+
+int main() {
+    std::cout << "SharedTripleBuffer tests:\n";
+
+    {
+        std::cout << "Test 1: reader gets the newest complete frame\n";
+        SharedTripleBuffer w, r;
+        bool ok = w.create("/test_triple_local", 64) && r.open("/test_triple_local", 64);
+
+        std::string out;
+        bool emptyBefore = ok && !r.acquire() && r.frontFrame() == 0;
+
+        std::memcpy(w.writeBuffer(), "in-place", 8);
+        w.commit(8);
+        w.publish("second");
+        w.publish("third");
+        bool gotLatest = r.readLatest(out) && out == "third" && r.frontFrame() == 3 && r.skipped() == 2;
+        bool noRepeat = !r.readLatest(out);
+
+        // While the reader holds "third", the writer keeps cycling through
+        // the other two buffers without disturbing it.
+        for (int i = 0; i < 10; i++) w.publish("frame" + std::to_string(i));
+        std::string held(static_cast<const char*>(r.frontData()), r.frontSize());
+        bool untouched = held == "third";
+        bool next = r.readLatest(out) && out == "frame9" && r.frontFrame() == 13;
+        bool tooBig = !w.publish(std::string(65, 'x'));
+        bool wrongSize = !SharedTripleBuffer().open("/test_triple_local", 128);
+
+        if (emptyBefore && gotLatest && noRepeat && untouched && next && tooBig && wrongSize)
+            std::cout << "[PASSED]\n\n";
+        else std::cout << "[FAILED] Got: " << out << " frame=" << r.frontFrame() << "\n\n";
+    }
+
+    {
+        std::cout << "Test 2: a reader that reopens takes over the right buffer\n";
+        SharedTripleBuffer w;
+        bool ok = w.create("/test_triple_reopen", 64);
+        std::string out;
+        {
+            SharedTripleBuffer first;
+            ok = ok && first.open("/test_triple_reopen", 64);
+            w.publish("A");
+            w.publish("B");
+            ok = ok && first.readLatest(out) && out == "B";
+        }
+
+        SharedTripleBuffer second;
+        ok = ok && second.open("/test_triple_reopen", 64);
+        w.publish("C");
+        w.publish("D");
+        ok = ok && second.readLatest(out) && out == "D";
+
+        // The writer moves on and fills its back buffer; the frame the
+        // reader holds must not change.
+        w.publish("E");
+        std::memcpy(w.writeBuffer(), "X", 1);
+        std::string held(static_cast<const char*>(second.frontData()), second.frontSize());
+        bool next = second.readLatest(out) && out == "E";
+
+        if (ok && held == "D" && next) std::cout << "[PASSED]\n\n";
+        else std::cout << "[FAILED] held: " << held << "\n\n";
+    }
+
+    {
+        std::cout << "Test 3: slow reader across processes, no torn frames\n";
+#ifdef _WIN32
+        std::cout << "[SKIPPED] needs fork()\n\n";
+#else
+        SharedTripleBuffer w;
+        if (!w.create(TRIPLE_NAME, CAPACITY)) {
+            std::cerr << "Failed to create triple buffer segment\n";
+            return 1;
+        }
+        pid_t pid = fork();
+        if (pid == 0) run_reader();
+
+        // The writer runs flat out; it never waits for the reader.
+        auto t0 = std::chrono::steady_clock::now();
+        for (int n = 1; n <= FRAMES; n++) {
+            w.publish(make_frame(n));
+            if (n % 64 == 0) std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        double took = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        std::cout << "writer published " << FRAMES << " frames in " << took << " ms\n";
+
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+            std::cout << "[PASSED]\n\n";
+        else std::cout << "[FAILED] reader status " << (WIFEXITED(status) ? WEXITSTATUS(status) : -1) << "\n\n";
+#endif
+    }
+
+    std::cout << "All tests done.\n";
+    return 0;
+}
@@ -0,0 +1,212 @@
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "../include/TypedChannel.h"
+#include "../include/Process.h"
+
+struct Sample {
+    std::uint32_t id;
+    std::uint32_t flags;
+    double value;
+    char name[16];
+};
+
+// Same size as Sample but declared as a newer revision.
+struct SampleV2 {
+    static constexpr std::uint16_t channelVersion = 2;
+    std::uint32_t id;
+    std::uint32_t flags;
+    double value;
+    char name[16];
+};
+
+static_assert(sizeof(Sample) == sizeof(SampleV2));
+static_assert(TypedChannel<Sample>::layoutTag != TypedChannel<SampleV2>::layoutTag);
+static_assert(channel_layout_tag<Sample>() == channel_layout_tag<Sample>());
+
+static Sample make(std::uint32_t i) {
+    Sample s{};
+    s.id = i;
+    s.flags = i * 7;
+    s.value = i + 0.5;
+    std::memcpy(s.name, "sample", 7);
+    return s;
+}
+
+void test_pipe_roundtrip() {
+    std::cout << "\n===== TEST 1: records over a pipe =====\n";
+
+    Pipe p;
+    bool ok = p.create();
+    assert(ok);
+    TypedChannel<Sample> writer(p), reader(p);
+
+    std::vector<Sample> batch;
+    for (std::uint32_t i = 0; i < 500; i++) batch.push_back(make(i));
+    ok = writer.send(make(1000));
+    assert(ok);
+    ok = writer.sendMany(batch);
+    assert(ok);
+    p.closeWrite();
+
+    Sample s;
+    ok = reader.receive(s);
+    assert(ok && s.id == 1000);
+    for (std::uint32_t i = 0; i < 500; i++) {
+        ok = reader.receive(s);
+        assert(ok);
+        assert(s.id == i && s.flags == i * 7 && s.value == i + 0.5);
+        assert(std::strcmp(s.name, "sample") == 0);
+    }
+    ok = reader.receive(s);
+    assert(!ok);
+
+    // Tag plus 501 records, nothing else on the wire.
+    assert(p.counters().snapshot().bytesOut == 8 + 501 * sizeof(Sample));
+    std::cout << "Test 1 passed.\n";
+}
+
+void test_layout_mismatch() {
+    std::cout << "\n===== TEST 2: reader rejects a different layout =====\n";
+
+    Pipe p;
+    bool ok = p.create();
+    assert(ok);
+    TypedChannel<Sample> writer(p);
+    TypedChannel<SampleV2> reader(p);
+    ok = writer.send(make(1));
+    assert(ok);
+
+    bool threw = false;
+    try {
+        SampleV2 s;
+        reader.receive(s);
+    } catch (const std::runtime_error& e) {
+        std::cout << "caught: " << e.what() << "\n";
+        threw = true;
+    }
+    assert(threw);
+    std::cout << "Test 2 passed.\n";
+}
+
+void test_shared_queue() {
+    std::cout << "\n===== TEST 3: records over a shared work queue =====\n";
+
+    SharedWorkQueue q;
+    bool ok = TypedChannel<Sample>::createQueue(q, "/typed_channel_test", 64);
+    assert(ok);
+    TypedChannel<Sample> ch(q);
+
+    for (std::uint32_t i = 0; i < 10; i++) {
+        ok = ch.send(make(i));
+        assert(ok);
+    }
+    Sample s;
+    for (std::uint32_t i = 0; i < 10; i++) {
+        ok = ch.receive(s);
+        assert(ok && s.id == i && s.value == i + 0.5);
+    }
+
+    // Same slot size, different version: the queue header refuses it.
+    SharedWorkQueue other;
+    ok = TypedChannel<SampleV2>::openQueue(other, "/typed_channel_test", 64);
+    assert(!ok);
+
+    SharedWorkQueue same;
+    ok = TypedChannel<Sample>::openQueue(same, "/typed_channel_test", 64);
+    assert(ok);
+
+    // A queue sized for something else cannot be wrapped.
+    SharedWorkQueue untyped;
+    ok = untyped.create("/typed_channel_untyped", 64, 128);
+    assert(ok);
+    bool threw = false;
+    try {
+        TypedChannel<Sample> bad(untyped);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    std::cout << "Test 3 passed.\n";
+}
+
+void test_child_process() {
+    std::cout << "\n===== TEST 4: records through a child's stdin/stdout =====\n";
+
+    Process child("./test_child_typed", {});
+    child.start();
+    TypedChannel<Sample> to(child.stdinStream()), from(child.stdoutStream());
+
+    std::vector<Sample> batch;
+    for (std::uint32_t i = 0; i < 200; i++) batch.push_back(make(i));
+    bool ok = to.sendMany(batch);
+    assert(ok);
+    child.closeStdin();
+
+    Sample s;
+    for (std::uint32_t i = 0; i < 200; i++) {
+        ok = from.receive(s);
+        assert(ok);
+        assert(s.id == i && s.value == 2 * (i + 0.5));
+    }
+    ok = from.receive(s);
+    assert(!ok);
+    int rc = child.wait();
+    assert(rc == 0);
+    std::cout << "Test 4 passed.\n";
+}
+
+void test_torn_record_and_closed_queue() {
+    std::cout << "\n===== TEST 5: torn records and a shut-down queue =====\n";
+
+    Pipe p;
+    bool ok = p.create();
+    assert(ok);
+    TypedChannel<Sample> writer(p), reader(p);
+    ok = writer.send(make(1));
+    assert(ok);
+    Sample half = make(2);
+    ok = p.writeBytes(&half, sizeof(half) / 2);
+    assert(ok);
+    p.closeWrite();
+
+    Sample s;
+    ok = reader.receive(s);
+    assert(ok && s.id == 1);
+    bool threw = false;
+    try {
+        reader.receive(s);
+    } catch (const std::runtime_error& e) {
+        std::cout << "caught: " << e.what() << "\n";
+        threw = true;
+    }
+    assert(threw);
+
+    // A full queue whose consumer has shut it down refuses the record
+    // instead of waiting for room.
+    SharedWorkQueue q;
+    ok = TypedChannel<Sample>::createQueue(q, "/typed_channel_closed", 4);
+    assert(ok);
+    TypedChannel<Sample> ch(q);
+    std::vector<Sample> fill(4, make(3));
+    ok = ch.sendMany(fill);
+    assert(ok);
+    q.shutdown();
+    ok = ch.send(make(4));
+    assert(!ok);
+    std::cout << "Test 5 passed.\n";
+}
+
+int main() {
+    test_pipe_roundtrip();
+    test_layout_mismatch();
+    test_shared_queue();
+    test_child_process();
+    test_torn_record_and_closed_queue();
+    std::cout << "\nAll typed channel tests passed.\n";
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <set>
+#include <string>
+
+#include "../include/WorkerPool.h"
+
+#ifndef _WIN32
+
+using Clock = std::chrono::steady_clock;
+
+static const char* WORKER = "./test_child_worker";
+
+void test_stealing_balances_skewed_load() {
+    std::cout << "\n===== TEST 1: idle workers steal a skewed backlog =====\n";
+
+    WorkerPool pool(WORKER, {}, 4);
+    pool.start();
+
+    // Everything lands on worker 0's deque; durations vary 100x.
+    int totalMs = 0;
+    for (int i = 0; i < 40; i++) {
+        int ms = (i % 10 == 0) ? 100 : 1;
+        totalMs += ms;
+        pool.submit(std::to_string(ms), 0);
+    }
+
+    auto t0 = Clock::now();
+    pool.run();
+    double took = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    std::cout << "serial " << totalMs << " ms, pool took " << took << " ms\n";
+
+    size_t completed = 0, stolen = 0;
+    for (size_t w = 0; w < pool.size(); w++) {
+        WorkerPool::WorkerStats s = pool.stats(w);
+        std::cout << "worker " << w << ": completed " << s.completed << ", stolen " << s.stolen << "\n";
+        assert(s.completed > 0);
+        assert(s.inFlight == 0 && s.queued == 0);
+        completed += s.completed;
+        stolen += s.stolen;
+    }
+    assert(completed == 40);
+    assert(stolen > 0);
+    assert(took < totalMs * 0.75);
+
+    for (WorkerPool::TaskId id = 0; id < 40; id++) {
+        const WorkerPool::TaskResult& r = pool.result(id);
+        assert(r.done && r.ok);
+        assert(r.reply.rfind(std::to_string((id % 10 == 0) ? 100 : 1) + " ", 0) == 0);
+    }
+
+    pool.shutdown();
+    std::cout << "Test 1 passed.\n";
+}
+
+void test_pipelined_depth_and_callback() {
+    std::cout << "\n===== TEST 2: several tasks in flight per worker =====\n";
+
+    WorkerPool pool(WORKER, {}, 2);
+    pool.setDepth(4);
+    size_t callbacks = 0;
+    pool.onComplete([&](WorkerPool::TaskId, const WorkerPool::TaskResult& r) {
+        assert(r.ok);
+        callbacks++;
+    });
+
+    for (int i = 0; i < 200; i++)
+        pool.submit("0");
+    pool.run();
+
+    assert(callbacks == 200);
+    std::set<std::string> pids;
+    for (WorkerPool::TaskId id = 0; id < 200; id++)
+        pids.insert(pool.result(id).reply.substr(2));
+    assert(pids.size() == 2);
+
+    std::cout << "Test 2 passed.\n";
+}
+
+void test_worker_crash() {
+    std::cout << "\n===== TEST 3: a crashing task is retried, then fails =====\n";
+
+    WorkerPool pool(WORKER, {}, 3);
+    pool.start();
+
+    WorkerPool::TaskId bad = pool.submit("crash");
+    std::vector<WorkerPool::TaskId> good;
+    for (int i = 0; i < 10; i++)
+        good.push_back(pool.submit("5"));
+
+    pool.run();
+
+    const WorkerPool::TaskResult& r = pool.result(bad);
+    assert(r.done && !r.ok && r.attempts == 2);
+    for (auto id : good)
+        assert(pool.result(id).ok);
+
+    size_t alive = 0;
+    for (size_t w = 0; w < pool.size(); w++)
+        alive += pool.stats(w).alive ? 1 : 0;
+    assert(alive == 1);
+
+    std::cout << "Test 3 passed.\n";
+}
+
+void test_unsolicited_output() {
+    std::cout << "\n===== TEST 4: a line with no task in flight is not a reply =====\n";
+
+    WorkerPool pool(WORKER, {}, 2);
+    pool.start();
+
+    // Worker 1's long task keeps run() going after worker 0 goes idle, so
+    // the stray line arrives with nothing in flight on worker 0.
+    WorkerPool::TaskId stray = pool.submit("stray", 0);
+    pool.submit("400", 1);
+    pool.run();
+    assert(pool.result(stray).reply.rfind("stray ", 0) == 0);
+    assert(pool.stats(0).unsolicited == 1);
+    assert(pool.errorOutput(0) == "not a reply\n");
+
+    WorkerPool::TaskId next = pool.submit("5", 0);
+    pool.run();
+    std::cout << "next reply: " << pool.result(next).reply << "\n";
+    assert(pool.result(next).reply.rfind("5 ", 0) == 0);
+
+    pool.shutdown();
+    std::cout << "Test 4 passed.\n";
+}
+
+void test_no_workers_left() {
+    std::cout << "\n===== TEST 5: tasks submitted after every worker died =====\n";
+
+    WorkerPool pool(WORKER, {}, 1);
+    pool.setMaxAttempts(1);
+    pool.start();
+    WorkerPool::TaskId crash = pool.submit("crash");
+    pool.run();
+    assert(pool.result(crash).done && !pool.result(crash).ok);
+
+    WorkerPool::TaskId late = pool.submit("5");
+    pool.run();
+    const WorkerPool::TaskResult& r = pool.result(late);
+    assert(r.done && !r.ok && r.attempts == 0);
+
+    std::cout << "Test 5 passed.\n";
+}
+
+int main() {
+    test_stealing_balances_skewed_load();
+    test_pipelined_depth_and_callback();
+    test_worker_crash();
+    test_unsolicited_output();
+    test_no_workers_left();
+
+    std::cout << "\nAll worker pool tests passed.\n";
+    return 0;
+}
+
+#else
+
+int main() {
+    std::cout << "WorkerPool tests are POSIX only; skipped on Windows.\n";
+    return 0;
+}
+
+#endif
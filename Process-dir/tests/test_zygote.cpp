@@ -0,0 +1,121 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <set>
+#include <string>
+#include <sstream>
+
+#include "../include/Process.h"
+#include "../include/SpawnServer.h"
+
+#ifndef _WIN32
+
+using Clock = std::chrono::steady_clock;
+
+static const char* TEMPLATE = "./test_child_zygote";
+
+struct Reply {
+    std::string checksum;
+    long pid = 0;
+    int initializations = 0;
+    std::string arg;
+};
+
+// Sends one request and reads the reply line; returns the time it took
+// from spawn to answer.
+static double first_reply(Process& p, Clock::time_point spawned, Reply& r) {
+    p.writeStdin("hello\n");
+    p.closeStdin();
+    std::istringstream in(p.readStdout());
+    in >> r.checksum >> r.pid >> r.initializations >> r.arg;
+    return std::chrono::duration<double, std::milli>(Clock::now() - spawned).count();
+}
+
+void test_warm_workers(SpawnServer& zygote, const Reply& cold) {
+    std::cout << "\n===== TEST 2: workers forked from the warmed template =====\n";
+
+    SpawnOptions opts;
+    opts.spawnServer = &zygote;
+    std::set<long> pids;
+    for (int i = 0; i < 4; i++) {
+        Process worker(TEMPLATE, { "worker" + std::to_string(i) }, opts);
+        auto t0 = Clock::now();
+        worker.start();
+        Reply r;
+        double ms = first_reply(worker, t0, r);
+        int code = worker.wait();
+        std::cout << "worker " << i << ": pid " << r.pid << ", first reply after " << ms << " ms\n";
+
+        assert(code == 0);
+        assert(r.checksum == cold.checksum);
+        assert(r.initializations == 1);   // inherited, not redone
+        assert(r.arg == "worker" + std::to_string(i));
+        assert(r.pid != zygote.serverPid());
+        assert(ms < 150);
+        pids.insert(r.pid);
+    }
+    assert(pids.size() == 4);
+    std::cout << "Test 2 passed.\n";
+}
+
+void test_spawn_many_from_template(SpawnServer& zygote) {
+    std::cout << "\n===== TEST 3: spawnMany through the template =====\n";
+
+    SpawnOptions opts;
+    opts.spawnServer = &zygote;
+    Process prototype(TEMPLATE, { "pool" }, opts);
+    auto t0 = Clock::now();
+    auto workers = Process::spawnMany(16, prototype);
+    for (auto& w : workers) w->writeStdin("x\n");
+    for (auto& w : workers) w->closeStdin();
+    std::set<std::string> replies;
+    for (auto& w : workers) {
+        replies.insert(w->readStdout());
+        int code = w->wait();
+        assert(code == 0);
+    }
+    double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    std::cout << "16 warm workers answered in " << ms << " ms\n";
+    assert(replies.size() == 16);
+    std::cout << "Test 3 passed.\n";
+}
+
+int main() {
+    std::cout << "\n===== TEST 1: cold start for comparison =====\n";
+    Process coldProc(TEMPLATE, { "cold" });
+    auto t0 = Clock::now();
+    coldProc.start();
+    Reply cold;
+    double coldMs = first_reply(coldProc, t0, cold);
+    int code = coldProc.wait();
+    assert(code == 0 && cold.initializations == 1);
+    std::cout << "cold worker: first reply after " << coldMs << " ms\n";
+    std::cout << "Test 1 passed.\n";
+
+    SpawnServer zygote;
+    t0 = Clock::now();
+    bool ok = zygote.startTemplate(TEMPLATE, {});
+    assert(ok);
+    std::cout << "template warm after "
+              << std::chrono::duration<double, std::milli>(Clock::now() - t0).count() << " ms\n";
+
+    test_warm_workers(zygote, cold);
+    test_spawn_many_from_template(zygote);
+
+    // A template that exits before it is ready is reported, not waited on forever.
+    SpawnServer broken;
+    ok = broken.startTemplate("/bin/true", {});
+    assert(!ok && !broken.running());
+
+    std::cout << "\nAll zygote tests passed.\n";
+    return 0;
+}
+
+#else
+
+int main() {
+    std::cout << "Zygote workers need fork(); skipped on Windows.\n";
+    return 0;
+}
+
+#endif